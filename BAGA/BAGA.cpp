@@ -17,6 +17,9 @@
 /* Include Files */
 #include "BAGA.h"
 #include "LowPower.h"
+#if defined(WDIE)
+#include <avr/wdt.h>
+#endif
 
 // Select the desired debug serial port:
 // * Serial (USB-CDC)
@@ -28,12 +31,76 @@ Si7020 _sensorHumidityTemperature();
 Si1132 _sensorLight();
 #endif
 
+/***
+* Function: BAGA_reduceSamples(T *samples, byte count, byte policy)
+* Description: Reduce the samples of one channel to a single value with
+*              integer math (sorts the array for the median and trimmed mean)
+* Params: samples - array of samples
+*         count - number of samples (1 to BAGA_FILTER_MAX_SAMPLES)
+*         policy - BAGA_FILTER_MEAN, BAGA_FILTER_MEDIAN or BAGA_FILTER_TRIMMED_MEAN
+* Returns: Reduced value (rounded to the nearest integer)
+***/
+template <typename T>
+static T BAGA_reduceSamples(T *samples, byte count, byte policy)
+{
+	signed long sum = 0;
+	byte first = 0, last = count;
+	byte i, j;
+	T value;
+	
+	if (policy != BAGA_FILTER_MEAN)
+	{
+		for (i = 1; i < count; i++) // Insertion sort (few samples)
+		{
+			value = samples[i];
+			for (j = i; (j > 0) && (samples[j - 1] > value); j--)
+			{
+				samples[j] = samples[j - 1];
+			}
+			samples[j] = value;
+		}
+		
+		if (policy == BAGA_FILTER_MEDIAN)
+		{
+			first = (count - 1) / 2; // One middle sample, or the two middle ones
+			last = (count / 2) + 1;
+		}
+		else
+		{
+			first = count / BAGA_FILTER_TRIM_DIVISOR;
+			last = count - first;
+		}
+	}
+	
+	for (i = first; i < last; i++)
+	{
+		sum += samples[i];
+	}
+	
+	count = last - first;
+	if (sum < 0)
+	{
+		return (sum - (count / 2)) / count;
+	}
+	
+	return (sum + (count / 2)) / count;
+}
+
 BAGA::BAGA()
 {
-	_bagaRelativeHumidity = 0;
-	_bagaTemperatureC = 0;
-	_bagaPressuremBar = 0;
+	_bagaRelativeHumidityCenti = 0;
+	_bagaTemperatureCentiC = 0;
 	_bagaPressurePa = 0;
+	_bagaSeaLevelFactor = BAGA_SEA_LEVEL_FACTOR_ONE;
+	_bagaRawRelativeHumidity = 0;
+	_bagaRawTemperature = 0;
+	_bagaSolarRadiationAdc = 0;
+	_bagaBatteryVoltageAdc = 0;
+	_bagaTimestampMs = 0;
+	_bagaWakeDurationUs = 0;
+	_bagaDerivedValid = false;
+	_bagaWdtStepQ4 = (unsigned long) BAGA_WDT_STEP_NOMINAL_US << BAGA_WDT_STEP_SHIFT;
+	_bagaWdtCalibrated = false;
 }
 
 /***
@@ -44,6 +111,8 @@ BAGA::BAGA()
 ***/
 byte BAGA::begin(void)
 {
+	I2C_BUS_TRACE_CALL("BAGA::begin");
+	
 	byte result = 0;
 	byte resultTemp = 0;
 	
@@ -117,20 +186,376 @@ byte BAGA::begin(void)
 /***
 * Function: readSensors(void)
 * Description: Makes a single measurement from all sensors
-*              and saves data in the private variables
+*              and saves data in the private variables.
+*              Takes at most BAGA_READ_SENSORS_MAX_MS, even if a
+*              sensor stops responding.
 * Params: none
-* Returns: the measured temperature in Celsius degrees
+* Returns: 0 if all sensors were read successfully, 1 if not
 ***/
 byte BAGA::readSensors(void)
 {
-	_sensorPressureTemperature.makeSingleMeasurement(); // BMP280 measurement
+	I2C_BUS_TRACE_REPORT("BAGA::readSensors");
+	
+	byte result = 0;
+	
+	_bagaTimestampMs = BAGAClock::nowMs();
+	result |= _sensorPressureTemperature.makeSingleMeasurement(); // BMP280 measurement
+	result |= _sensorHumidityTemperature.readRawRelHumidity(&_bagaRawRelativeHumidity);
+	result |= _sensorHumidityTemperature.readRawTemperaturePostHumidity(&_bagaRawTemperature);
 	
-	_bagaRelativeHumidity = _sensorHumidityTemperature.readRelHumidity();
-	_bagaTemperatureC = _sensorHumidityTemperature.readTemperaturePostHumidity();
+	// Integer math only (floating point values are computed on demand by the getters)
+	_bagaRelativeHumidityCenti = SI7020_RH_CENTI_FROM_RAW(_bagaRawRelativeHumidity);
+	_bagaTemperatureCentiC = SI7020_TEMPERATURE_CENTI_FROM_RAW(_bagaRawTemperature);
 	_bagaPressurePa = _sensorPressureTemperature.readPressure();
-	_bagaPressuremBar = ((float)_bagaPressurePa) / 100;
+	readAdcChannels();
+	_bagaDerivedValid = false; // Derived metrics are computed again on first access
+	
+	return (result != 0);
+}
+
+/***
+* Function: readSensors(byte samples, byte policy)
+* Description: Takes several back-to-back measurements of all sensors
+*              (pipelined, see readSensorsPipelined()) and saves one
+*              value per channel, reduced with integer math. With more
+*              than one sample, every sample uses the cheapest modes
+*              (BAGA_FILTER_SI7020_RESOLUTION, BAGA_FILTER_BMP280_PROFILE)
+*              so each channel is reduced over samples of one resolution;
+*              the configured settings are restored afterwards. The wake
+*              time is available from readWakeDurationUs().
+* Params: samples - number of samples, 1 to BAGA_FILTER_MAX_SAMPLES
+*         policy - BAGA_FILTER_MEAN, BAGA_FILTER_MEDIAN or BAGA_FILTER_TRIMMED_MEAN
+* Returns: 0 if all sensors were read successfully, 1 if not
+***/
+byte BAGA::readSensors(byte samples, byte policy)
+{
+	I2C_BUS_TRACE_REPORT("BAGA::readSensors(samples)");
+	
+	signed int temperature[BAGA_FILTER_MAX_SAMPLES], relHumidity[BAGA_FILTER_MAX_SAMPLES];
+	signed int solarRadiation[BAGA_FILTER_MAX_SAMPLES], batteryVoltage[BAGA_FILTER_MAX_SAMPLES];
+	signed long pressure[BAGA_FILTER_MAX_SAMPLES];
+	byte resolution = _sensorHumidityTemperature.getResolution();
+	byte profile = _sensorPressureTemperature.getProfile();
+	byte tempOversampling = _sensorPressureTemperature.getTempOversampling();
+	byte pressureOversampling = _sensorPressureTemperature.getPressureOversampling();
+	bool restoreResolution = false;
+	unsigned long timestampMs = BAGAClock::nowMs();
+	unsigned long startUs = micros();
+	byte result = 0;
+	byte i;
+	
+	if (samples < 1)
+	{
+		samples = 1;
+	}
+	else if (samples > BAGA_FILTER_MAX_SAMPLES)
+	{
+		samples = BAGA_FILTER_MAX_SAMPLES;
+	}
+	
+	if (samples > 1) // Cheapest modes
+	{
+		if (resolution != BAGA_FILTER_SI7020_RESOLUTION)
+		{
+			restoreResolution = true; // Even if it fails: the register may have been written
+			result |= _sensorHumidityTemperature.setResolution(BAGA_FILTER_SI7020_RESOLUTION);
+		}
+		_sensorPressureTemperature.setProfile(BAGA_FILTER_BMP280_PROFILE);
+	}
+	
+	for (i = 0; i < samples; i++)
+	{
+		result |= measureSensorsPipelined();
+		
+		temperature[i] = _bagaTemperatureCentiC;
+		relHumidity[i] = _bagaRelativeHumidityCenti;
+		pressure[i] = _bagaPressurePa;
+		solarRadiation[i] = _bagaSolarRadiationAdc;
+		batteryVoltage[i] = _bagaBatteryVoltageAdc;
+	}
+	
+	if (samples > 1) // Configured settings
+	{
+		if ((restoreResolution == true) && (_sensorHumidityTemperature.setResolution(resolution) != 0))
+		{
+			result |= _sensorHumidityTemperature.setResolution(resolution); // Second attempt
+		}
+		if (profile == BMP280_PROFILE_CUSTOM)
+		{
+			_sensorPressureTemperature.setTempOversampling(tempOversampling);
+			_sensorPressureTemperature.setPressureOversampling(pressureOversampling);
+		}
+		else
+		{
+			_sensorPressureTemperature.setProfile(profile);
+		}
+	}
+	
+	_bagaTemperatureCentiC = BAGA_reduceSamples(temperature, samples, policy);
+	_bagaRelativeHumidityCenti = BAGA_reduceSamples(relHumidity, samples, policy);
+	_bagaPressurePa = BAGA_reduceSamples(pressure, samples, policy);
+	_bagaSolarRadiationAdc = BAGA_reduceSamples(solarRadiation, samples, policy);
+	_bagaBatteryVoltageAdc = BAGA_reduceSamples(batteryVoltage, samples, policy);
+	_bagaTimestampMs = timestampMs; // Start of the first sample
+	
+	_bagaWakeDurationUs = micros() - startUs;
+	
+	return (result != 0);
 }
 
+/***
+* Function: readSensorsPipelined(void)
+* Description: Same as readSensors(), but both sensors convert at the same
+*              time: the BMP280 and the Si7020 (No Hold Master) are
+*              triggered, the MCU idles for the longer of the two
+*              conversion times and then both results are collected.
+*              The wake time is the maximum of the two latencies instead
+*              of their sum. Takes at most BAGA_READ_SENSORS_PIPELINED_MAX_MS.
+* Params: none
+* Returns: 0 if all sensors were read successfully, 1 if not
+***/
+byte BAGA::readSensorsPipelined(void)
+{
+	I2C_BUS_TRACE_REPORT("BAGA::readSensorsPipelined");
+	
+	unsigned long startUs = micros();
+	byte result;
+	
+	result = measureSensorsPipelined();
+	
+	_bagaWakeDurationUs = micros() - startUs;
+	
+	return result;
+}
+
+/***
+* Function: measureSensorsPipelined(void)
+* Description: Trigger both sensors, idle for the longer conversion time
+*              and collect the results (see readSensorsPipelined())
+* Params: none
+* Returns: 0 if all sensors were read successfully, 1 if not
+***/
+byte BAGA::measureSensorsPipelined(void)
+{
+	byte result = 0;
+	bool pressureReady = false, humidityReady = false;
+	unsigned long startUs = micros();
+	unsigned long conversionUs, pressureConversionUs;
+	
+	_bagaTimestampMs = BAGAClock::nowMs();
+	result |= _sensorPressureTemperature.startMeasurement();
+	result |= _sensorHumidityTemperature.startRelHumidity();
+	
+	conversionUs = _sensorHumidityTemperature.getConversionTimeUs();
+	pressureConversionUs = _sensorPressureTemperature.getMeasurementTimeUs();
+	if (pressureConversionUs > conversionUs)
+	{
+		conversionUs = pressureConversionUs;
+	}
+	
+	if (result == 0)
+	{
+		idleUntil(startUs, conversionUs);
+		
+		// Both conversions should be done, poll in case the clocks run slow
+		do
+		{
+			if (pressureReady == false)
+			{
+				pressureReady = _sensorPressureTemperature.isReady();
+			}
+			if (humidityReady == false)
+			{
+				humidityReady = (_sensorHumidityTemperature.fetch() == 0);
+			}
+			if ((pressureReady == true) && (humidityReady == true))
+			{
+				break;
+			}
+		} while ((micros() - startUs) < (conversionUs + (BAGA_PIPELINE_POLL_TIMEOUT_MS * 1000UL)));
+		
+		result |= (pressureReady == false) || (humidityReady == false);
+	}
+	
+	if (pressureReady == true)
+	{
+		result |= _sensorPressureTemperature.fetch();
+	}
+	if (humidityReady == true)
+	{
+		_bagaRawRelativeHumidity = _sensorHumidityTemperature.getRawRelHumidity();
+		result |= _sensorHumidityTemperature.readRawTemperaturePostHumidity(&_bagaRawTemperature);
+	}
+	
+	_bagaRelativeHumidityCenti = SI7020_RH_CENTI_FROM_RAW(_bagaRawRelativeHumidity);
+	_bagaTemperatureCentiC = SI7020_TEMPERATURE_CENTI_FROM_RAW(_bagaRawTemperature);
+	_bagaPressurePa = _sensorPressureTemperature.readPressure();
+	readAdcChannels();
+	_bagaDerivedValid = false; // Derived metrics are computed again on first access
+	
+	return (result != 0);
+}
+
+/***
+* Function: readWakeDurationUs(void)
+* Description: Get how long the last readSensorsPipelined() call kept
+*              the MCU awake (idle sleep included)
+* Params: none
+* Returns: Duration in microseconds
+***/
+unsigned long BAGA::readWakeDurationUs(void)
+{
+	return _bagaWakeDurationUs;
+}
+
+/***
+* Function: readSample(void)
+* Description: Takes a snapshot of the last readSensors() measurement,
+*              integer encoded, ready to be buffered, logged or sent.
+*              The timestamp is the BAGAClock time of the measurement.
+* Params: none
+* Returns: Sample structure
+***/
+BAGA::Sample BAGA::readSample(void)
+{
+	Sample sample;
+	signed int relHumidity = _bagaRelativeHumidityCenti;
+	
+	if (relHumidity < 0)
+	{
+		relHumidity = 0; // The Si7020 formula can go slightly out of range
+	}
+	else if (relHumidity > 10000)
+	{
+		relHumidity = 10000;
+	}
+	
+	sample.timestampMs = _bagaTimestampMs;
+	sample.pressurePa = _bagaPressurePa;
+	sample.temperatureCentiC = _bagaTemperatureCentiC;
+	sample.relHumidityCenti = relHumidity;
+	sample.solarRadiationAdc = _bagaSolarRadiationAdc;
+	sample.batteryVoltageMv = BAGA_BATTERY_ADC_TO_MV(_bagaBatteryVoltageAdc);
+	
+	return sample;
+}
+
+/***
+* Function: readSensorsRaw(void)
+* Description: Makes a single measurement from all sensors and saves
+*              only the uncompensated words (raw capture logging mode).
+*              Use readCalibrationData() once per log file to allow a
+*              host computer to compensate the data later.
+* Params: none
+* Returns: 0 if all sensors were read successfully, 1 if not
+***/
+byte BAGA::readSensorsRaw(void)
+{
+	I2C_BUS_TRACE_REPORT("BAGA::readSensorsRaw");
+	
+	byte result = 0;
+	
+	_bagaTimestampMs = BAGAClock::nowMs();
+	result |= _sensorPressureTemperature.makeSingleMeasurement(); // BMP280 measurement
+	result |= _sensorHumidityTemperature.readRawRelHumidity(&_bagaRawRelativeHumidity);
+	result |= _sensorHumidityTemperature.readRawTemperaturePostHumidity(&_bagaRawTemperature);
+	readAdcChannels();
+	
+	return (result != 0);
+}
+
+
+/***
+* Function: readRawPressure(void)
+* Description: Reads the uncompensated BMP280 pressure word
+*              from the previous readSensorsRaw() call
+* Params: none
+* Returns: the raw 20-bit pressure value
+***/
+signed long BAGA::readRawPressure(void)
+{
+	return _sensorPressureTemperature.getRawPressure();
+}
+
+
+/***
+* Function: readRawPressureTemperature(void)
+* Description: Reads the uncompensated BMP280 temperature word
+*              from the previous readSensorsRaw() call
+* Params: none
+* Returns: the raw 20-bit temperature value
+***/
+signed long BAGA::readRawPressureTemperature(void)
+{
+	return _sensorPressureTemperature.getRawTemperature();
+}
+
+
+/***
+* Function: readRawRelHumidity(void)
+* Description: Reads the uncompensated Si7020 relative humidity word
+*              from the previous readSensorsRaw() call
+* Params: none
+* Returns: the raw 16-bit relative humidity value
+***/
+unsigned short BAGA::readRawRelHumidity(void)
+{
+	return _bagaRawRelativeHumidity;
+}
+
+
+/***
+* Function: readRawTemperature(void)
+* Description: Reads the uncompensated Si7020 temperature word
+*              from the previous readSensorsRaw() call
+* Params: none
+* Returns: the raw 16-bit temperature value
+***/
+unsigned short BAGA::readRawTemperature(void)
+{
+	return _bagaRawTemperature;
+}
+
+
+/***
+* Function: readRawSolarRadiation(void)
+* Description: Reads the oversampled solar radiation ADC value
+*              from the previous readSensors() or readSensorsRaw() call
+* Params: none
+* Returns: ADC value from 0 to BAGA_ADC_FULL_SCALE
+***/
+unsigned int BAGA::readRawSolarRadiation(void)
+{
+	return _bagaSolarRadiationAdc;
+}
+
+
+/***
+* Function: readRawBatteryVoltage(void)
+* Description: Reads the oversampled battery voltage ADC value
+*              from the previous readSensors() or readSensorsRaw() call
+* Params: none
+* Returns: ADC value from 0 to BAGA_ADC_FULL_SCALE
+***/
+unsigned int BAGA::readRawBatteryVoltage(void)
+{
+	return _bagaBatteryVoltageAdc;
+}
+
+
+/***
+* Function: readCalibrationData(BMP280CalibrationData *calib)
+* Description: Reads the BMP280 factory calibration data needed
+*              to compensate the raw pressure and temperature words
+* Params: calib - Structure to save the calibration data in
+* Returns: none
+***/
+void BAGA::readCalibrationData(BMP280CalibrationData *calib)
+{
+	_sensorPressureTemperature.getCalibrationData(calib);
+}
+
+
 /***
 * Function: readTemperatureC(void)
 * Description: Reads the temperature in Celsius degrees
@@ -140,7 +565,20 @@ byte BAGA::readSensors(void)
 ***/
 float BAGA::readTemperatureC(void)
 {
-	return _bagaTemperatureC;
+	return ((float) _bagaTemperatureCentiC) / 100;
+}
+
+
+/***
+* Function: readTemperatureCentiC(void)
+* Description: Reads the temperature in 0.01 Celsius degrees
+*              from the previous readSensors() call
+* Params: none
+* Returns: the measured temperature in 0.01 Celsius degrees (e.g. 2508 = 25.08 C)
+***/
+signed int BAGA::readTemperatureCentiC(void)
+{
+	return _bagaTemperatureCentiC;
 }
 
 
@@ -153,7 +591,7 @@ float BAGA::readTemperatureC(void)
 ***/
 float BAGA::readTemperatureF(void)
 {
-	return BAGA_TEMPERATURE_C_TO_F(_bagaTemperatureC);
+	return BAGA_TEMPERATURE_C_TO_F(readTemperatureC());
 }
 
 
@@ -166,7 +604,7 @@ float BAGA::readTemperatureF(void)
 ***/
 unsigned long BAGA::readTemperatureK(void)
 {
-	return BAGA_TEMPERATURE_C_TO_K(_bagaTemperatureC);
+	return BAGA_TEMPERATURE_C_TO_K(readTemperatureC());
 }
 
 
@@ -192,35 +630,9 @@ float BAGA::readHeatIndexC(void)
 ***/
 float BAGA::readHeatIndexF(void)
 {
-	float heatIndex;
-	float temperature;
-	float relativeHumidity;
-	
-	temperature = readTemperatureF();
-	relativeHumidity = readRelHumidity();
-	
-	heatIndex = 0.5 * (temperature + 61.0 + ((temperature - 68.0) * 1.2) + (relativeHumidity * 0.094));
+	updateDerivedMetrics();
 	
-	if (heatIndex >= 80)
-	{
-		heatIndex = 0.5 * (temperature + 61.0 + ((temperature - 68.0) * 1.2) + (relativeHumidity * 0.094));
-		
-		if (heatIndex >= 80)
-		{
-			heatIndex = -42.379 + (2.04901523 * temperature) + (10.14333127 * relativeHumidity) - (0.22475541 * temperature * relativeHumidity) - (0.00683783 * temperature * temperature) - (0.05481717 * relativeHumidity * relativeHumidity) + (0.00122874 * temperature * temperature * relativeHumidity) + (0.00085282 * temperature * relativeHumidity * relativeHumidity) - (0.00000199 * temperature * temperature * relativeHumidity * relativeHumidity);
-		}
-		
-		if ((relativeHumidity < 13) && (temperature > 80) && (temperature < 112))
-		{
-			heatIndex = ((13 - relativeHumidity) / 4) * sqrt((17 - abs(temperature - 95)) / 17);
-		}
-		else if ((relativeHumidity > 85) && (temperature >= 80) && (temperature <= 87))
-		{
-			heatIndex = ((relativeHumidity - 85) / 10) * ((87 - temperature) / 5);
-		}
-	}
-	
-	return heatIndex;
+	return _bagaHeatIndexF;
 }
 
 
@@ -246,7 +658,39 @@ float BAGA::readHeatIndexK(void)
 */
 float BAGA::readAbsHumidity(void)
 {
-	return 2.16679 * ((float)_bagaPressurePa) / BAGA_TEMPERATURE_C_TO_K(_bagaTemperatureC);
+	updateDerivedMetrics();
+	
+	return _bagaAbsHumidity;
+}
+
+
+/***
+* Function: readDewPointC(void)
+* Description: Reads the dew point in Celsius degrees
+*              from the previous readSensors() call
+* Params: none
+* Returns: The dew point in Celsius degrees
+*/
+float BAGA::readDewPointC(void)
+{
+	updateDerivedMetrics();
+	
+	return _bagaDewPointC;
+}
+
+
+/***
+* Function: readVaporPressurePa(void)
+* Description: Reads the water vapor partial pressure
+*              from the previous readSensors() call
+* Params: none
+* Returns: The vapor pressure in Pa
+*/
+float BAGA::readVaporPressurePa(void)
+{
+	updateDerivedMetrics();
+	
+	return _bagaVaporPressurePa;
 }
 
 
@@ -259,7 +703,20 @@ float BAGA::readAbsHumidity(void)
 */
 float BAGA::readRelHumidity(void)
 {
-	return _bagaRelativeHumidity;
+	return ((float) _bagaRelativeHumidityCenti) / 100;
+}
+
+
+/***
+* Function: readRelHumidityCenti(void)
+* Description: Reads the relative humidity in 0.01 %
+*              from the previous readSensors() call
+* Params: none
+* Returns: The relative humidity in 0.01 % (e.g. 4512 = 45.12 %)
+*/
+signed int BAGA::readRelHumidityCenti(void)
+{
+	return _bagaRelativeHumidityCenti;
 }
 
 
@@ -272,7 +729,7 @@ float BAGA::readRelHumidity(void)
 */
 float BAGA::readAbsPressuremBar(void)
 {
-	return _bagaPressuremBar;
+	return BAGA_PRESSURE_PA_TO_MBAR(_bagaPressurePa);
 }
 
 
@@ -285,7 +742,7 @@ float BAGA::readAbsPressuremBar(void)
 */
 float BAGA::readAbsPressureBar(void)
 {
-	return _bagaPressuremBar/1000;
+	return BAGA_PRESSURE_PA_TO_MBAR(_bagaPressurePa)/1000;
 }
 
 
@@ -324,7 +781,7 @@ float BAGA::readAbsPressureKPa(void)
 */
 float BAGA::readAbsPressurePsi(void)
 {
-	return BAGA_PRESSURE_MBAR_TO_PSI(_bagaPressuremBar);
+	return BAGA_PRESSURE_MBAR_TO_PSI(BAGA_PRESSURE_PA_TO_MBAR(_bagaPressurePa));
 }
 
 
@@ -337,7 +794,7 @@ float BAGA::readAbsPressurePsi(void)
 */
 float BAGA::readRelPressuremBar(void)
 {
-	return _bagaPressuremBar - BAGA_SEA_LEVEL_PRESSURE_MBAR;
+	return BAGA_PRESSURE_PA_TO_MBAR(_bagaPressurePa) - BAGA_SEA_LEVEL_PRESSURE_MBAR;
 }
 
 
@@ -350,7 +807,7 @@ float BAGA::readRelPressuremBar(void)
 */
 float BAGA::readRelPressureBar(void)
 {
-	return (_bagaPressuremBar - BAGA_SEA_LEVEL_PRESSURE_MBAR)/1000;
+	return (BAGA_PRESSURE_PA_TO_MBAR(_bagaPressurePa) - BAGA_SEA_LEVEL_PRESSURE_MBAR)/1000;
 }
 
 
@@ -389,7 +846,70 @@ float BAGA::readRelPressureKPa(void)
 */
 float BAGA::readRelPressurePsi(void)
 {
-	return BAGA_PRESSURE_MBAR_TO_PSI(_bagaPressuremBar - BAGA_SEA_LEVEL_PRESSURE_MBAR);
+	return BAGA_PRESSURE_MBAR_TO_PSI(BAGA_PRESSURE_PA_TO_MBAR(_bagaPressurePa) - BAGA_SEA_LEVEL_PRESSURE_MBAR);
+}
+
+/***
+* Function: setStationAltitude(float altitudeM)
+* Description: Sets the station altitude used to reduce the measured pressure
+*              to sea level (QNH, standard atmosphere). The reduction factor
+*              is computed once here so each reading only costs a multiply.
+*              It is limited to BAGA_SEA_LEVEL_FACTOR_MAX (about 6700 m).
+* Params: altitudeM - Station altitude in meters
+* Returns: none
+*/
+void BAGA::setStationAltitude(float altitudeM)
+{
+	float factor = pow(1 - (0.0065 * altitudeM / 288.15), -5.25588) * BAGA_SEA_LEVEL_FACTOR_ONE + 0.5;
+	
+	if (factor > BAGA_SEA_LEVEL_FACTOR_MAX)
+	{
+		factor = BAGA_SEA_LEVEL_FACTOR_MAX; // Keeps the product of readSeaLevelPressurePa() within 32 bits
+	}
+	
+	_bagaSeaLevelFactor = (unsigned long) factor;
+}
+
+
+/***
+* Function: readSeaLevelPressurePa(void)
+* Description: Reads the pressure reduced to sea level (QNH) in Pascal
+*              from the previous readSensors() call
+* Params: none
+* Returns: The sea level pressure in Pa (within 6 Pa)
+*/
+signed long BAGA::readSeaLevelPressurePa(void)
+{
+	// Pressure rounded to 4 Pa: up to BAGA_SEA_LEVEL_PRESSURE_MAX_PA the product fits a 32-bit multiply
+	unsigned long pressure = ((unsigned long) _bagaPressurePa + (1 << (BAGA_SEA_LEVEL_PRESSURE_SHIFT - 1))) >> BAGA_SEA_LEVEL_PRESSURE_SHIFT;
+	
+	return (signed long) ((pressure * _bagaSeaLevelFactor) >> (BAGA_SEA_LEVEL_FACTOR_SHIFT - BAGA_SEA_LEVEL_PRESSURE_SHIFT));
+}
+
+
+/***
+* Function: readSeaLevelPressuremBar(void)
+* Description: Reads the pressure reduced to sea level (QNH) in millibar
+*              from the previous readSensors() call
+* Params: none
+* Returns: The sea level pressure in millibar
+*/
+float BAGA::readSeaLevelPressuremBar(void)
+{
+	return BAGA_PRESSURE_PA_TO_MBAR(readSeaLevelPressurePa());
+}
+
+
+/***
+* Function: readAltitudeCm(void)
+* Description: Reads the pressure altitude (standard atmosphere, referred
+*              to 1013.25 mbar) from the previous readSensors() call
+* Params: none
+* Returns: The altitude in centimeters
+*/
+signed long BAGA::readAltitudeCm(void)
+{
+	return _sensorPressureTemperature.calcAltitudeFast(_bagaPressurePa, BAGA_SEA_LEVEL_PRESSURE_PA);
 }
 
 #ifdef LIGHT_SENSOR_SI1132
@@ -447,9 +967,22 @@ int BAGA::readSolarRadiationAdc(void)
 }
 
 
+/***
+* Function: readBatteryVoltageAdc(void)
+* Description: Reads the battery voltage raw value
+* Params: none
+* Returns: The battery voltage raw ADC value
+*/
+int BAGA::readBatteryVoltageAdc(void)
+{
+	return analogRead(BAGA_BATTERY_VOLTAGE_PIN);
+}
+
+
 /***
 * Function: readSolarRadiation(void)
 * Description: Reads the Solar radiation in Watt per square meter
+*              from the previous readSensors() call
 * Params: none
 * Returns: The solar radiation value
 */
@@ -457,8 +990,8 @@ unsigned long BAGA::readSolarRadiation(void)
 {
 	unsigned long voltage;
 	
-	voltage = (unsigned long)analogRead(BAGA_SOLAR_RADIATION_PIN);
-	voltage = voltage * 45000 / 1023; // AVDD is aprox. 4500 mV
+	voltage = (unsigned long)_bagaSolarRadiationAdc;
+	voltage = voltage * 45000 / BAGA_ADC_FULL_SCALE; // AVDD is aprox. 4500 mV
 	voltage /= 25; // OpAmp gain is 2.5
 	
 	return voltage;
@@ -468,6 +1001,7 @@ unsigned long BAGA::readSolarRadiation(void)
 /***
 * Function: readBatteryVoltage(void)
 * Description: Reads the battery voltage in mV
+*              from the previous readSensors() call
 * Params: none
 * Returns: The batteries' voltage value in mV
 */
@@ -475,8 +1009,7 @@ unsigned long BAGA::readBatteryVoltage(void)
 {
 	unsigned long voltage;
 	
-	voltage = (unsigned long)analogRead(BAGA_BATTERY_VOLTAGE_PIN);
-	voltage = voltage * 4500 / 1023; // AVDD is aprox. 4500 mV
+	voltage = BAGA_BATTERY_ADC_TO_MV(_bagaBatteryVoltageAdc);
 	
 	return  voltage;
 }
@@ -547,78 +1080,201 @@ void BAGA::blinkForever(int times)
 
 /***
 * Function: sleep(unsigned long periodMs, adc_t acdState)
-* Description: Enter sleep mode (power down)
+* Description: Enter sleep mode (power down) for a period measured with
+*              the calibrated watchdog: the first watchdog step runs in
+*              Idle mode and is timed with micros() (see calibrateWatchdog()),
+*              the power down steps are chosen from the corrected periods
+*              and the remainder below one step is spent in Idle mode.
+*              The power down time, which millis() does not count, is
+*              added to BAGAClock.
 * Params: periodMs - period in milliseconds
 *         acdState - ADC state on sleep mode
-* Returns: none
+* Returns: Estimated time slept in milliseconds
 */
-void BAGA::sleep(unsigned long periodMs, adc_t acdState)
+unsigned long BAGA::sleep(unsigned long periodMs, adc_t acdState)
 {
-	period_t sleepPeriod;
+	unsigned long chunkMs, remainingUs, stepUs, startUs;
+	unsigned long sleptUs, poweredDownUs, sleptMs = 0;
+	signed char step;
 	
-//#ifdef LowPower_h
-
-	do{
-		if (periodMs > 8000)
-		{
-			sleepPeriod = SLEEP_8S;
-			periodMs -= 8000;
-		}
-		else if (periodMs > 4000)
-		{
-			sleepPeriod = SLEEP_4S;
-			periodMs -= 4000;
-		}
-		else if (periodMs > 2000)
-		{
-			sleepPeriod = SLEEP_2S;
-			periodMs -= 2000;
-		}
-		else if (periodMs > 1000)
-		{
-			sleepPeriod = SLEEP_1S;
-			periodMs -= 1000;
-		}
-		else if (periodMs > 500)
-		{
-			sleepPeriod = SLEEP_500MS;
-			periodMs -= 500;
-		}
-		else if (periodMs > 250)
-		{
-			sleepPeriod = SLEEP_250MS;
-			periodMs -= 250;
-		}
-		else if (periodMs > 120)
+	while (periodMs > 0)
+	{
+		chunkMs = (periodMs > BAGA_SLEEP_CHUNK_MS) ? BAGA_SLEEP_CHUNK_MS : periodMs; // Keep microseconds in 32 bits
+		periodMs -= chunkMs;
+		remainingUs = chunkMs * 1000;
+		sleptUs = 0;
+		poweredDownUs = 0;
+		
+		if (remainingUs > (_bagaWdtStepQ4 >> BAGA_WDT_STEP_SHIFT))
 		{
-			sleepPeriod = SLEEP_120MS;
-			periodMs -= 120;
+			sleptUs = calibrateWatchdog();
+			remainingUs = (sleptUs < remainingUs) ? (remainingUs - sleptUs) : 0;
 		}
-		else if (periodMs > 60)
+		
+		for (step = BAGA_WDT_STEPS - 1; step >= 0; step--)
 		{
-			sleepPeriod = SLEEP_60MS;
-			periodMs -= 60;
+			stepUs = ((_bagaWdtStepQ4 << step) >> BAGA_WDT_STEP_SHIFT) + BAGA_WAKE_UP_US;
+			
+			while (remainingUs >= stepUs)
+			{
+				LowPower.powerDown((period_t) step, acdState, BOD_OFF);
+				remainingUs -= stepUs;
+				poweredDownUs += stepUs;
+			}
 		}
-		else if (periodMs > 30)
+		BAGAClock::advanceUs(poweredDownUs); // Timer0 was stopped
+		sleptUs += poweredDownUs;
+		
+		startUs = micros();
+		idleUntil(startUs, remainingUs);
+		sleptUs += micros() - startUs;
+		
+		sleptMs += (sleptUs + 500) / 1000;
+	}
+	
+	return sleptMs;
+}
+
+
+/***
+* Function: calibrateWatchdog(void)
+* Description: Time one watchdog step (SLEEP_15MS) in Idle mode against
+*              micros() and add it to the filtered step period used by
+*              sleep(). The watchdog oscillator is only accurate to
+*              about 10 % and drifts with temperature and voltage.
+* Params: none
+* Returns: Time spent in microseconds
+***/
+unsigned long BAGA::calibrateWatchdog(void)
+{
+	unsigned long startUs = micros();
+	unsigned long periodUs;
+	
+#if defined(WDIE)
+	LowPower.idle(SLEEP_15MS, ADC_ON, TIMER4_ON, TIMER3_ON, TIMER1_ON,
+				  TIMER0_ON, SPI_ON, USART1_ON, TWI_ON, USB_ON); // Starts the watchdog
+	
+	while ((WDTCSR & (1 << WDIE)) != 0) // Cleared by the watchdog interrupt
+	{
+		if ((micros() - startUs) > (2 * BAGA_WDT_STEP_NOMINAL_US))
 		{
-			sleepPeriod = SLEEP_30MS;
-			periodMs -= 30;
+			wdt_disable(); // Do not leave it running: it could reset the MCU
+			return micros() - startUs; // Watchdog interrupt not seen, keep the last value
 		}
-		else if (periodMs > 15)
+		LowPower.idle(SLEEP_FOREVER, ADC_ON, TIMER4_ON, TIMER3_ON, TIMER1_ON,
+					  TIMER0_ON, SPI_ON, USART1_ON, TWI_ON, USB_ON);
+	}
+	
+	periodUs = micros() - startUs;
+	
+	if (_bagaWdtCalibrated == false)
+	{
+		_bagaWdtStepQ4 = periodUs << BAGA_WDT_STEP_SHIFT;
+		_bagaWdtCalibrated = true;
+	}
+	else
+	{
+		// Exponential average: micros() has a 4 us resolution
+		_bagaWdtStepQ4 = _bagaWdtStepQ4 - (_bagaWdtStepQ4 / BAGA_WDT_FILTER_WEIGHT) + ((periodUs << BAGA_WDT_STEP_SHIFT) / BAGA_WDT_FILTER_WEIGHT);
+	}
+#else
+	periodUs = 0;
+#endif
+	
+	return periodUs;
+}
+
+
+/***
+* Function: readAdcChannels(void)
+* Description: Oversampled solar radiation and battery voltage readings
+*              (BAGA_ADC_EXTRA_BITS), converted with the CPU asleep
+* Params: none
+* Returns: none
+***/
+void BAGA::readAdcChannels(void)
+{
+	static const byte pins[2] = { BAGA_SOLAR_RADIATION_PIN, BAGA_BATTERY_VOLTAGE_PIN };
+	unsigned int values[2];
+	
+	_adc.readBatch(pins, values, 2, BAGA_ADC_EXTRA_BITS);
+	
+	_bagaSolarRadiationAdc = values[0];
+	_bagaBatteryVoltageAdc = values[1];
+}
+
+
+/***
+* Function: idleUntil(unsigned long startUs, unsigned long periodUs)
+* Description: Idle sleep (CPU stopped, timers and TWI running) until
+*              periodUs have elapsed since startUs. The Timer0 overflow
+*              interrupt wakes the MCU every 1024 us to check the time.
+* Params: startUs - micros() timestamp
+*         periodUs - period in microseconds
+* Returns: none
+***/
+void BAGA::idleUntil(unsigned long startUs, unsigned long periodUs)
+{
+	while ((micros() - startUs) < periodUs)
+	{
+		LowPower.idle(SLEEP_FOREVER, ADC_ON, TIMER4_ON, TIMER3_ON, TIMER1_ON,
+					  TIMER0_ON, SPI_ON, USART1_ON, TWI_ON, USB_ON);
+	}
+}
+
+
+/***
+* Function: updateDerivedMetrics(void)
+* Description: Computes the heat index, vapor pressure, dew point and
+*              absolute humidity once per measurement (readSensors()
+*              invalidates them), so reading them in several units
+*              costs a single evaluation
+* Params: none
+* Returns: none
+***/
+void BAGA::updateDerivedMetrics(void)
+{
+	float temperature, temperatureF, relativeHumidity;
+	float heatIndex, gamma;
+	
+	if (_bagaDerivedValid == true)
+	{
+		return;
+	}
+	
+	temperature = readTemperatureC();
+	temperatureF = BAGA_TEMPERATURE_C_TO_F(temperature);
+	relativeHumidity = readRelHumidity();
+	
+	// Heat index (NWS): simple formula, Rothfusz regression if (simple + T) / 2 >= 80 F
+	heatIndex = 0.5 * (temperatureF + 61.0 + ((temperatureF - 68.0) * 1.2) + (relativeHumidity * 0.094));
+	
+	if (((heatIndex + temperatureF) / 2) >= 80)
+	{
+		heatIndex = -42.379 + (2.04901523 * temperatureF) + (10.14333127 * relativeHumidity) - (0.22475541 * temperatureF * relativeHumidity) - (0.00683783 * temperatureF * temperatureF) - (0.05481717 * relativeHumidity * relativeHumidity) + (0.00122874 * temperatureF * temperatureF * relativeHumidity) + (0.00085282 * temperatureF * relativeHumidity * relativeHumidity) - (0.00000199 * temperatureF * temperatureF * relativeHumidity * relativeHumidity);
+		
+		if ((relativeHumidity < 13) && (temperatureF >= 80) && (temperatureF <= 112))
 		{
-			sleepPeriod = SLEEP_15MS;
-			periodMs -= 15;
+			heatIndex -= ((13 - relativeHumidity) / 4) * sqrt((17 - fabs(temperatureF - 95)) / 17);
 		}
-		else
+		else if ((relativeHumidity > 85) && (temperatureF >= 80) && (temperatureF <= 87))
 		{
-			periodMs = 0;
-			break; // Delays below 15ms are ignored
+			heatIndex += ((relativeHumidity - 85) / 10) * ((87 - temperatureF) / 5);
 		}
-		
-		LowPower.powerDown(sleepPeriod, acdState, BOD_OFF);
-		
-
-	} while(periodMs > 0);
-
-//#endif	
+	}
+	_bagaHeatIndexF = heatIndex;
+	
+	// Vapor pressure and dew point (Magnus formula)
+	if (relativeHumidity < 0.01)
+	{
+		relativeHumidity = 0.01; // Keep log() defined
+	}
+	gamma = log(relativeHumidity / 100) + ((BAGA_MAGNUS_A * temperature) / (BAGA_MAGNUS_B + temperature));
+	_bagaVaporPressurePa = BAGA_MAGNUS_C * exp(gamma);
+	_bagaDewPointC = (BAGA_MAGNUS_B * gamma) / (BAGA_MAGNUS_A - gamma);
+	
+	// Absolute humidity from the ideal gas law of the water vapor
+	_bagaAbsHumidity = BAGA_WATER_VAPOR_FACTOR * _bagaVaporPressurePa / BAGA_TEMPERATURE_C_TO_K(temperature);
+	
+	_bagaDerivedValid = true;
 }
@@ -27,6 +27,8 @@
 #include <BMP280.h>
 #include <Si7020.h>
 #include <LowPower.h>
+#include "BAGAAdc.h"
+#include "BAGAClock.h"
 
 //#define 	LIGHT_SENSOR_SI1132
 #define 	LIGHT_SENSOR_PHOTO_TRANSISTOR
@@ -40,32 +42,109 @@
 #define		BAGA_DIGITAL_A2								20
 
 #define		BAGA_TEMPERATURE_C_TO_F(x) 					((x * 1.8) + 32)
-#define		BAGA_TEMPERATURE_C_TO_K(x) 					(x + 273.75)
+#define		BAGA_TEMPERATURE_C_TO_K(x) 					(x + 273.15)
 #define		BAGA_TEMPERATURE_F_TO_C(x) 					((x - 32) / 1.8)
 #define		BAGA_TEMPERATURE_F_TO_K(x) 					((x + 459.67) * 5 / 9)
 
+#define		BAGA_ADC_EXTRA_BITS							2 // Solar radiation and battery readings: 16 conversions, 12 bits
+#define		BAGA_ADC_FULL_SCALE							BAGA_ADC_MAX_VALUE(BAGA_ADC_EXTRA_BITS)
+#define		BAGA_BATTERY_ADC_TO_MV(x)					((((unsigned long)(x)) * 4500) / BAGA_ADC_FULL_SCALE) // AVDD is aprox. 4500 mV
+
+#define 	BAGA_PRESSURE_PA_TO_MBAR(x)					(((float)(x)) / 100)
 #define 	BAGA_PRESSURE_MBAR_TO_KPA(x)				(x * 100)
 #define 	BAGA_PRESSURE_MBAR_TO_PSI(x)				(x * 0.0145037738)
 
+// Magnus formula over water (Sonntag 1990), vapor pressure in Pa
+#define		BAGA_MAGNUS_A								17.62
+#define		BAGA_MAGNUS_B								243.12 // Celsius degrees
+#define		BAGA_MAGNUS_C								611.2 // Pa
+#define		BAGA_WATER_VAPOR_FACTOR						2.16679 // g.K/J (1 / specific gas constant of water vapor)
+
 #define		BAGA_SEA_LEVEL_PRESSURE_PA					101325
 #define		BAGA_SEA_LEVEL_PRESSURE_MBAR				1013.25
 
+// Worst case duration of readSensors() with every I2C transaction timing out
+#define		BAGA_READ_SENSORS_MAX_MS					(BMP280_SINGLE_MEASUREMENT_MAX_MS + ((2 * SI7020_I2C_TRANSACTION_MAX_US) / 1000) + (BAGA_ADC_BATCH_MAX_US(2, BAGA_ADC_EXTRA_BITS) / 1000) + 1)
+
+// readSensors(samples, policy) reduction of the samples of each channel
+#define		BAGA_FILTER_MEAN							0
+#define		BAGA_FILTER_MEDIAN							1
+#define		BAGA_FILTER_TRIMMED_MEAN					2 // Mean without the lowest and highest quarter
+#define		BAGA_FILTER_MAX_SAMPLES						8
+#define		BAGA_FILTER_TRIM_DIVISOR					4
+#define		BAGA_FILTER_SI7020_RESOLUTION				SI7020_RES_RH08_TEMP12 // Cheapest mode: 6.9 ms instead of 22.8 ms, 0.5 %RH and 0.04 C steps
+#define		BAGA_FILTER_BMP280_PROFILE					BMP280_PROFILE_ULTRA_LOW_POWER // Cheapest mode: x1 oversampling, 2.6 Pa steps
+
+// Pipelined readSensorsPipelined(): extra polling allowed after the nominal conversion time
+#define		BAGA_PIPELINE_POLL_TIMEOUT_MS				10
+#define		BAGA_PIPELINE_BMP280_TRANSACTIONS			3 // startMeasurement(), last isReady() poll, fetch()
+#define		BAGA_PIPELINE_SI7020_TRANSACTIONS			3 // startRelHumidity(), last fetch() poll, readRawTemperaturePostHumidity()
+#define		BAGA_PIPELINE_BUS_MAX_US					((BAGA_PIPELINE_BMP280_TRANSACTIONS * BMP280_I2C_TRANSACTION_MAX_US) + (BAGA_PIPELINE_SI7020_TRANSACTIONS * SI7020_I2C_TRANSACTION_MAX_US))
+#define		BAGA_PIPELINE_CONVERSION_MAX_US				((BMP280_MEAS_TIME_MAX_US > SI7020_CONV_TIME_RH12_TEMP14_US) ? BMP280_MEAS_TIME_MAX_US : SI7020_CONV_TIME_RH12_TEMP14_US) // Slowest settings of both sensors
+#define		BAGA_READ_SENSORS_PIPELINED_MAX_MS			(((BAGA_PIPELINE_CONVERSION_MAX_US + BAGA_PIPELINE_BUS_MAX_US) / 1000) + BAGA_PIPELINE_POLL_TIMEOUT_MS + (BAGA_ADC_BATCH_MAX_US(2, BAGA_ADC_EXTRA_BITS) / 1000) + 2)
+
+// Calibrated watchdog sleep
+#define		BAGA_WDT_STEP_NOMINAL_US					16000 // SLEEP_15MS: 2K cycles of the 128 kHz watchdog oscillator
+#define		BAGA_WDT_STEPS								10 // SLEEP_15MS to SLEEP_8S, each step doubles the period
+#define		BAGA_WDT_STEP_SHIFT							4 // Measured step period kept in 1/16 us
+#define		BAGA_WDT_FILTER_WEIGHT						8 // Each calibration moves the period 1/8 of the way
+#define		BAGA_SLEEP_CHUNK_MS							3600000UL // Longest sleep per calibration (keeps the microsecond total within 32 bits)
+#ifdef F_CPU
+#define		BAGA_WAKE_UP_US								((16384UL * 1000) / (F_CPU / 1000)) // Crystal start-up after power down (16K CK)
+#else
+#define		BAGA_WAKE_UP_US								0
+#endif
+
+#define		BAGA_SEA_LEVEL_FACTOR_ONE					65536 // Sea level reduction factor 1.0 (Q16)
+#define		BAGA_SEA_LEVEL_FACTOR_SHIFT					16
+#define		BAGA_SEA_LEVEL_PRESSURE_SHIFT				2 // Pressure taken in 4 Pa steps so the product fits 32 bits
+#define		BAGA_SEA_LEVEL_PRESSURE_MAX_PA				110000 // Upper limit of the BMP280 operating range
+#define		BAGA_SEA_LEVEL_FACTOR_MAX					(0xFFFFFFFFUL / ((BAGA_SEA_LEVEL_PRESSURE_MAX_PA >> BAGA_SEA_LEVEL_PRESSURE_SHIFT) + 1)) // About 2.38 (6700 m)
+
 class BAGA
 {
 	public:
+		/* Integer encoded snapshot of one measurement (16 bytes) */
+		struct Sample
+		{
+			uint32_t	timestampMs; // BAGAClock::nowMs() when the measurement started (low 32 bits, sleep included)
+			uint32_t	pressurePa; // Absolute pressure in Pa
+			int16_t		temperatureCentiC; // Temperature in 0.01 Celsius degrees
+			uint16_t	relHumidityCenti; // Relative humidity in 0.01 %
+			uint16_t	solarRadiationAdc; // Solar radiation ADC value (0 to BAGA_ADC_FULL_SCALE)
+			uint16_t	batteryVoltageMv; // Battery voltage in mV
+		} __attribute__((packed));
+		
 		BAGA();
 		
 		byte 			begin(void);
 		byte			readSensors(void);
+		byte			readSensors(byte samples, byte policy);
+		byte			readSensorsRaw(void);
+		byte			readSensorsPipelined(void);
+		unsigned long	readWakeDurationUs(void);
+		Sample			readSample(void);
+		
+		signed long		readRawPressure(void);
+		signed long		readRawPressureTemperature(void);
+		unsigned short	readRawRelHumidity(void);
+		unsigned short	readRawTemperature(void);
+		unsigned int	readRawSolarRadiation(void);
+		unsigned int	readRawBatteryVoltage(void);
+		void			readCalibrationData(BMP280CalibrationData *calib);
 		
 		float			readTemperatureC(void);
+		signed int		readTemperatureCentiC(void);
 		float 			readTemperatureF(void);
 		unsigned long	readTemperatureK(void);
 		float 			readHeatIndexC(void);
 		float 			readHeatIndexF(void);
 		float 			readHeatIndexK(void);
 		float 			readAbsHumidity(void);
+		float			readDewPointC(void);
+		float			readVaporPressurePa(void);
 		float 			readRelHumidity(void);
+		signed int		readRelHumidityCenti(void);
 
 		float 			readAbsPressuremBar(void);
 		float 			readAbsPressureBar(void);
@@ -77,6 +156,11 @@ class BAGA
 		signed long		readRelPressurePa(void);
 		float 			readRelPressureKPa(void);
 		float 			readRelPressurePsi(void);
+		
+		void			setStationAltitude(float altitudeM);
+		signed long		readSeaLevelPressurePa(void);
+		float 			readSeaLevelPressuremBar(void);
+		signed long		readAltitudeCm(void);
 
 #ifdef LIGHT_SENSOR_SI1132	
 		unsigned int 	readUVIndex(void);
@@ -85,24 +169,45 @@ class BAGA
 #endif
 		
 		int 			readSolarRadiationAdc(void);
+		int 			readBatteryVoltageAdc(void);
 		unsigned long 	readSolarRadiation(void);
 		unsigned long 	readBatteryVoltage(void);
 		void 			setLedOn(void);	// Turn LED on
 		void 			setLedOff(void); // Turn LED off
 		void 			blink(int times); // Blink the LED
 		void 			blinkForever(int times); // Blink the LED forever (blocking function)
-		void			sleep(unsigned long periodMs, adc_t acdState); // Sleep in ms
+		unsigned long	sleep(unsigned long periodMs, adc_t acdState); // Sleep in ms, returns the time slept
+		unsigned long	calibrateWatchdog(void); // Measure the watchdog period
 	private:
-		float 			_bagaRelativeHumidity; // Relative Humidity in %
-		float			_bagaTemperatureC; // Temperature in Celsius degrees
-		float 			_bagaPressuremBar; // Pressure in millibar
+		signed int		_bagaRelativeHumidityCenti; // Relative Humidity in 0.01 %
+		signed int		_bagaTemperatureCentiC; // Temperature in 0.01 Celsius degrees
 		signed long 	_bagaPressurePa; // Pressure in Pa
+		unsigned long	_bagaSeaLevelFactor; // Sea level (QNH) reduction factor in Q16
+		unsigned short	_bagaRawRelativeHumidity; // Uncompensated Si7020 relative humidity word
+		unsigned short	_bagaRawTemperature; // Uncompensated Si7020 temperature word
+		unsigned int	_bagaSolarRadiationAdc; // Solar radiation ADC value (BAGA_ADC_FULL_SCALE)
+		unsigned int	_bagaBatteryVoltageAdc; // Battery voltage ADC value (BAGA_ADC_FULL_SCALE)
+		unsigned long	_bagaTimestampMs; // BAGAClock::nowMs() when the last measurement started (low 32 bits)
+		unsigned long	_bagaWakeDurationUs; // Duration of the last readSensorsPipelined()
+		unsigned long	_bagaWdtStepQ4; // Measured SLEEP_15MS watchdog period in 1/16 us
+		bool			_bagaWdtCalibrated; // _bagaWdtStepQ4 holds a measurement
+		bool			_bagaDerivedValid; // Derived metrics below match the last measurement
+		float			_bagaHeatIndexF; // Heat index in Fahrenheit degrees
+		float			_bagaDewPointC; // Dew point in Celsius degrees
+		float			_bagaVaporPressurePa; // Water vapor partial pressure in Pa
+		float			_bagaAbsHumidity; // Absolute humidity in grams per cubic meter
 	
 		BMP280 _sensorPressureTemperature;
 		Si7020 _sensorHumidityTemperature;
+		BAGAAdc _adc;
 #ifdef LIGHT_SENSOR_SI1132
 		Si1132 _sensorLight;
 #endif
+
+		byte			measureSensorsPipelined(void);
+		void			readAdcChannels(void);
+		void			idleUntil(unsigned long startUs, unsigned long periodUs);
+		void			updateDerivedMetrics(void);
 };
 
 #endif
\ No newline at end of file
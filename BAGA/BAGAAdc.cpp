@@ -0,0 +1,262 @@
+/*
+* File:    BAGAAdc.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/************************************************************************
+* BAGA A3
+*
+* Oversampled ADC readings in ADC Noise Reduction sleep mode
+*************************************************************************/
+
+/* Include Files */
+#include "BAGAAdc.h"
+#include "BAGAClock.h"
+
+
+/***
+* Function: BAGAAdc_readPolled(byte pin, unsigned long samples, byte extraBits)
+* Description: Oversampled reading of one analog pin with analogRead()
+* Params: pin - analog pin (A0, A1, ...)
+*         samples - number of conversions (BAGA_ADC_SAMPLES(extraBits))
+*         extraBits - extra bits of resolution
+* Returns: Reading from 0 to BAGA_ADC_MAX_VALUE(extraBits)
+***/
+static unsigned int BAGAAdc_readPolled(byte pin, unsigned long samples, byte extraBits)
+{
+	unsigned long sum = 0;
+	unsigned long i;
+
+	for (i = 0; i < samples; i++)
+	{
+		sum += analogRead(pin);
+	}
+
+	return sum >> extraBits;
+}
+
+#if defined(__AVR__)
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#define		BAGA_ADC_REFERENCE							DEFAULT // AVCC, same as analogRead()
+
+static volatile unsigned long adcSum; // Sum of the conversions of the current reading
+static volatile bool adcDone; // Set by the ADC interrupt
+
+/***
+* Function: ISR(ADC_vect)
+* Description: Conversion complete: add the result and wake the main loop
+***/
+ISR(ADC_vect)
+{
+	adcSum += ADC;
+	adcDone = true;
+}
+
+
+/***
+* Function: BAGAAdc_selectChannel(byte pin)
+* Description: Select the ADC input of an analog pin (same mapping as
+*              analogRead()) and disable its digital input buffer until
+*              readBatch() restores DIDR0
+* Params: pin - analog pin (A0, A1, ...) or channel number
+* Returns: none
+***/
+static void BAGAAdc_selectChannel(byte pin)
+{
+#if defined(analogPinToChannel)
+#if defined(__AVR_ATmega32U4__)
+	if (pin >= 18)
+	{
+		pin -= 18; // Allow for channel or pin numbers
+	}
+#endif
+	pin = analogPinToChannel(pin);
+#else
+	if (pin >= 14)
+	{
+		pin -= 14; // Allow for channel or pin numbers
+	}
+#endif
+
+#if defined(MUX5)
+	ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+#endif
+	ADMUX = (BAGA_ADC_REFERENCE << 6) | (pin & 0x07);
+
+#if defined(DIDR0)
+	if (pin < 8)
+	{
+		DIDR0 |= (1 << pin); // Digital input buffer off (less noise and power)
+	}
+#endif
+}
+
+
+/***
+* Function: BAGAAdc_convert(void)
+* Description: One conversion with the CPU asleep. Entering ADC Noise
+*              Reduction mode starts it; if another interrupt (e.g. the
+*              Timer0 tick) wakes the MCU first, it idles until the ADC
+*              interrupt without starting a new conversion. It gives up
+*              if no conversion is running (ADSC and ADIF clear) or after
+*              BAGA_ADC_WAKE_UPS_MAX other wake-ups.
+* Params: none
+* Returns: 0 if the conversion was added to adcSum, 1 if not
+***/
+static byte BAGAAdc_convert(void)
+{
+	byte wakeUps = 0;
+
+	adcDone = false;
+
+	set_sleep_mode(SLEEP_MODE_ADC);
+	noInterrupts();
+	sleep_enable();
+	interrupts(); // Takes effect after the next instruction: no wake-up is lost
+	sleep_cpu();
+	sleep_disable();
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	noInterrupts();
+	while (adcDone == false)
+	{
+		if (((ADCSRA & ((1 << ADSC) | (1 << ADIF))) == 0) || (wakeUps >= BAGA_ADC_WAKE_UPS_MAX))
+		{
+			interrupts();
+			return 1; // The ADC interrupt will not come
+		}
+
+		sleep_enable();
+		interrupts();
+		sleep_cpu();
+		sleep_disable();
+		noInterrupts();
+		wakeUps++;
+	}
+	interrupts();
+
+	return 0;
+}
+
+
+/***
+* Function: readBatch(const byte *pins, unsigned int *values, byte count, byte extraBits)
+* Description: Oversampled readings of several analog pins in one batch.
+*              Each reading is the sum of 4^extraBits conversions shifted
+*              right by extraBits (BAGA_ADC_RESOLUTION_BITS + extraBits bits).
+*              The first conversion after switching inputs is discarded.
+*              If a conversion does not complete, the current and the
+*              remaining pins are read with analogRead() instead.
+* Params: pins - analog pins (A0, A1, ...)
+*         values - readings, one per pin
+*         count - number of pins
+*         extraBits - extra bits of resolution (0 to BAGA_ADC_MAX_EXTRA_BITS)
+* Returns: 0 if all conversions ran in ADC Noise Reduction mode,
+*          1 if the batch fell back to analogRead()
+***/
+byte BAGAAdc::readBatch(const byte *pins, unsigned int *values, byte count, byte extraBits)
+{
+	unsigned long samples, i, stoppedNs;
+	unsigned long conversions = 0;
+	byte adcsra = ADCSRA;
+#if defined(DIDR0)
+	byte didr0 = DIDR0;
+#endif
+	byte adcPrescalerBits = (adcsra & 0x07) ? (adcsra & 0x07) : 1; // ADPS2:0, division factor 2^n
+	byte channel;
+	byte result = 0;
+
+	if (extraBits > BAGA_ADC_MAX_EXTRA_BITS)
+	{
+		extraBits = BAGA_ADC_MAX_EXTRA_BITS;
+	}
+	samples = BAGA_ADC_SAMPLES(extraBits);
+	stoppedNs = ((13UL << adcPrescalerBits) * 1000) / (F_CPU / 1000000); // Timer0 stops during each conversion (ns)
+
+	ADCSRA = (adcsra & ~(1 << ADATE)) | (1 << ADEN) | (1 << ADIE) | (1 << ADIF); // Single conversions, interrupt on completion, no stale flag
+
+	for (channel = 0; channel < count; channel++)
+	{
+		if (result == 0)
+		{
+			BAGAAdc_selectChannel(pins[channel]);
+			result |= BAGAAdc_convert(); // Let the input settle
+
+			adcSum = 0;
+			for (i = 0; (i < samples) && (result == 0); i++)
+			{
+				result |= BAGAAdc_convert();
+			}
+
+			conversions += (result == 0) ? (samples + 1) : i; // Sleep conversions that completed
+		}
+
+		if (result == 0)
+		{
+			values[channel] = adcSum >> extraBits;
+		}
+		else
+		{
+			ADCSRA &= ~(1 << ADIE); // No more sleep conversions
+			values[channel] = BAGAAdc_readPolled(pins[channel], samples, extraBits);
+		}
+	}
+
+	ADCSRA = adcsra & ~(1 << ADIE); // analogRead() polls the conversion
+#if defined(DIDR0)
+	DIDR0 = didr0; // Digital input buffers as they were
+#endif
+
+	BAGAClock::advanceUs(conversions * stoppedNs / 1000);
+
+	return result;
+}
+
+#else
+
+/***
+* Function: readBatch(const byte *pins, unsigned int *values, byte count, byte extraBits)
+* Description: Oversampled readings of several analog pins (analogRead()
+*              fallback for non-AVR targets)
+***/
+byte BAGAAdc::readBatch(const byte *pins, unsigned int *values, byte count, byte extraBits)
+{
+	unsigned long samples;
+	byte channel;
+
+	if (extraBits > BAGA_ADC_MAX_EXTRA_BITS)
+	{
+		extraBits = BAGA_ADC_MAX_EXTRA_BITS;
+	}
+	samples = BAGA_ADC_SAMPLES(extraBits);
+
+	for (channel = 0; channel < count; channel++)
+	{
+		values[channel] = BAGAAdc_readPolled(pins[channel], samples, extraBits);
+	}
+
+	return 0;
+}
+
+#endif
+
+
+/***
+* Function: read(byte pin, byte extraBits)
+* Description: Oversampled reading of one analog pin (see readBatch())
+* Params: pin - analog pin (A0, A1, ...)
+*         extraBits - extra bits of resolution (0 to BAGA_ADC_MAX_EXTRA_BITS)
+* Returns: Reading from 0 to BAGA_ADC_MAX_VALUE(extraBits)
+***/
+unsigned int BAGAAdc::read(byte pin, byte extraBits)
+{
+	unsigned int value;
+
+	readBatch(&pin, &value, 1, extraBits);
+
+	return value;
+}
@@ -0,0 +1,53 @@
+/*
+* File:    BAGAAdc.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/************************************************************************
+* BAGA A3
+*
+* Oversampled ADC readings in ADC Noise Reduction sleep mode
+*
+* Each conversion is started by entering ADC Noise Reduction mode: the
+* CPU and I/O clocks stop while the ADC converts, and the ADC interrupt
+* wakes the MCU with the result. 4^n conversions are added and shifted
+* right by n (decimation) to get n extra bits of resolution.
+* The I/O clock also stops Timer0, so millis() falls behind by about
+* 13 ADC clock cycles per conversion; that time is added to BAGAClock.
+*
+* If the ADC interrupt does not come (no conversion running, or more than
+* BAGA_ADC_WAKE_UPS_MAX other wake-ups), the rest of the batch falls back
+* to analogRead(). The digital input buffers of the pins are disabled
+* during the batch only (DIDR0 is restored).
+*
+* On non-AVR targets the conversions fall back to analogRead().
+*************************************************************************/
+
+#ifndef BAGA_ADC_H
+#define BAGA_ADC_H
+
+/* Include Files */
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define		BAGA_ADC_RESOLUTION_BITS					10
+#define		BAGA_ADC_MAX_EXTRA_BITS						6 // 4096 conversions, the sum still fits 32 bits
+#define		BAGA_ADC_MAX_VALUE(extraBits)				(1023UL << (extraBits)) // Largest decimated value
+#define		BAGA_ADC_SAMPLES(extraBits)					(1UL << (2 * (extraBits))) // Conversions per reading
+#define		BAGA_ADC_CONVERSION_US						120 // 13 ADC clocks at 125 kHz, wake-up included
+#define		BAGA_ADC_WAKE_UPS_MAX						8 // Other interrupts allowed during one conversion (Timer0 ticks every 1024 us)
+#define		BAGA_ADC_TIMEOUT_US							(BAGA_ADC_WAKE_UPS_MAX * 1024UL) // Longest wait for a conversion that never ends
+#define		BAGA_ADC_BATCH_MAX_US(pins, extraBits)		(((unsigned long)(pins) * (BAGA_ADC_SAMPLES(extraBits) + 1) * BAGA_ADC_CONVERSION_US) + BAGA_ADC_TIMEOUT_US) // readBatch() duration
+
+class BAGAAdc
+{
+	public:
+		unsigned int	read(byte pin, byte extraBits); // Oversampled reading of one analog pin
+		byte			readBatch(const byte *pins, unsigned int *values, byte count, byte extraBits); // Oversampled readings of several pins
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*
+* File:    BAGAClock.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/************************************************************************
+* BAGA A3
+*
+* Monotonic time base
+*************************************************************************/
+
+/* Include Files */
+#include "BAGAClock.h"
+
+unsigned long long BAGAClock::_clockMs = 0;
+uint32_t BAGAClock::_lastMillis = 0;
+unsigned long BAGAClock::_carryUs = 0;
+
+/***
+* Function: nowMs(void)
+* Description: Get the time since start-up, including the time spent in
+*              power down. Never wraps.
+* Params: none
+* Returns: Time in milliseconds
+***/
+unsigned long long BAGAClock::nowMs(void)
+{
+	uint32_t current = millis();
+
+	_clockMs += (uint32_t) (current - _lastMillis); // Wrap-safe difference
+	_lastMillis = current;
+
+	return _clockMs;
+}
+
+
+/***
+* Function: nowSeconds(void)
+* Description: Get the time since start-up in seconds (136 years range)
+* Params: none
+* Returns: Time in seconds
+***/
+unsigned long BAGAClock::nowSeconds(void)
+{
+	return (unsigned long) (nowMs() / 1000);
+}
+
+
+/***
+* Function: advanceUs(unsigned long us)
+* Description: Add time that millis() did not count (Timer0 stopped)
+* Params: us - time in microseconds
+* Returns: none
+***/
+void BAGAClock::advanceUs(unsigned long us)
+{
+	nowMs(); // Account for the time counted by millis() first
+
+	_carryUs += us % 1000;
+	_clockMs += (us / 1000) + (_carryUs / 1000);
+	_carryUs %= 1000;
+}
+
+
+/***
+* Function: getMsString(char *str)
+* Description: Write nowMs() as a decimal string
+* Params: str - output buffer of at least BAGA_CLOCK_STRING_LENGTH chars
+* Returns: str
+***/
+char *BAGAClock::getMsString(char *str)
+{
+	unsigned long long value = nowMs();
+	char digits[BAGA_CLOCK_STRING_LENGTH];
+	byte length = 0;
+	byte i;
+
+	do
+	{
+		digits[length++] = '0' + (value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	for (i = 0; i < length; i++)
+	{
+		str[i] = digits[length - 1 - i];
+	}
+	str[length] = '\0';
+
+	return str;
+}
@@ -0,0 +1,45 @@
+/*
+* File:    BAGAClock.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/************************************************************************
+* BAGA A3
+*
+* Monotonic time base
+*
+* 64-bit millisecond counter built on millis() that keeps counting while
+* Timer0 is stopped: BAGA::sleep() (power down) and the ADC Noise
+* Reduction conversions add the time they spend with the I/O clock off.
+* It does not wrap (millis() wraps after 49.7 days) as long as it is
+* read at least once every 49 days of awake time.
+*************************************************************************/
+
+#ifndef BAGA_CLOCK_H
+#define BAGA_CLOCK_H
+
+/* Include Files */
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define		BAGA_CLOCK_STRING_LENGTH					21 // Longest getMsString() output with the terminator
+
+class BAGAClock
+{
+	public:
+		static unsigned long long	nowMs(void); // Milliseconds since start-up, sleep included
+		static unsigned long		nowSeconds(void); // Seconds since start-up, sleep included
+		static void					advanceUs(unsigned long us); // Add time spent with Timer0 stopped
+		static char					*getMsString(char *str); // nowMs() as a decimal string
+
+	private:
+		static unsigned long long	_clockMs; // Time up to _lastMillis
+		static uint32_t				_lastMillis; // millis() at the last update
+		static unsigned long		_carryUs; // Time added with advanceUs() below 1 ms
+};
+
+#endif
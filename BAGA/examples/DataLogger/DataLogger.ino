@@ -11,7 +11,7 @@
 *
 * This example reads data periodically, saves it to the MicroSD Card and
 * enters in sleep mode. The timestamp is the system uptime in
-* milliseconds.
+* milliseconds, sleep time included (BAGAClock).
 *
 * HW Compatibility:
 * 	Schematic: A2
@@ -63,7 +63,7 @@ SdFile configFile;							// Configuration file
 
 /* Globals */
 char fileString[MAX_LINE_LENGTH + 1];		// String to read each line from file
-unsigned long timestamp;					// Timestamp
+char timestampString[BAGA_CLOCK_STRING_LENGTH];	// Timestamp (BAGAClock milliseconds)
 unsigned long ID = 0; 						// Measurements counter
 
 /* Strings */
@@ -260,8 +260,8 @@ void loop() {
 	{
 		String dataString = "";
 
-		/* Print the current millis value as system timestamp */
-		dataString += String(millis());
+		/* Print the system uptime (sleep included) as timestamp */
+		dataString += String(BAGAClock::getMsString(timestampString));
 		dataString += ",";
 		
 		/* Build the string with the values from the sensors */
@@ -15,7 +15,9 @@
 * uses a configuration file to set the date and time.
 * Use the config.txt file (in this folder) to configure the system.
 * Adjust date, time and sampling period and place the file on the root
-* of the SD card.
+* of the SD card. The optional D line sets the clock drift correction in
+* ppm (positive if the clock runs slow, e.g. D12.5); SWClock::sync()
+* learns it from a reference time.
 *
 * HW Compatibility:
 * 	Schematic: A2
@@ -68,8 +70,9 @@ SWClock clock;								// SWCLock instance
 
 /* Globals */
 char fileString[MAX_LINE_LENGTH + 1];		// String to read each line from file
-char clockString[21];						// String to save the converted date and time
-unsigned long timestamp;					// Timestamp
+unsigned long long timestamp;				// BAGAClock time of the last clock update
+char timestampString[BAGA_CLOCK_STRING_LENGTH];	// Timestamp (BAGAClock milliseconds)
+unsigned long elapsedS;						// Seconds since the last clock update
 unsigned long ID = 0; 						// Measurements counter
 
 /* Strings */
@@ -170,8 +173,8 @@ void setup() {
 					/* Initialize SWClock */
 					clock.begin(fileString+1);
 					
-					/* Save current millis value */
-					timestamp = millis();
+					/* Save current BAGAClock value */
+					timestamp = BAGAClock::nowMs();
 
 					#if defined(BAGA_DEBUG)
 					DebugSerial.print("Time: ");
@@ -181,6 +184,20 @@ void setup() {
 					DebugSerial.println(")");
 					#endif
 				}
+				/* Check if it's a clock Drift configuration line */
+				else if ((fileString[0] == 'D') ||  (fileString[0] == 'd'))
+				{
+					/* Set the drift correction (ppm) */
+					clock.setDriftString(fileString+1);
+
+					#if defined(BAGA_DEBUG)
+					DebugSerial.print("Drift: ");
+					DebugSerial.print(fileString+1);
+					DebugSerial.print(" ppm, converted value: ");
+					DebugSerial.print(clock.getDrift(), DEC);
+					DebugSerial.println(" ppb");
+					#endif
+				}
 				/* Check if it's a sampling Period configuration line */
 				else if ((fileString[0] == 'P') ||  (fileString[0] == 'p'))
 				{
@@ -286,17 +303,14 @@ void loop() {
 	
 		if(clock.isInitialized() == true)
 		{			
-			/* Build the timestamp from the emulated clock */
-			clock.getDateTimeString(clockString);
-
-			/* Print timestamp */
-			dataString += String(clockString);
+			/* Print timestamp from the emulated clock */
+			dataString += String(clock.formatDateTime(SWCLOCK_FORMAT_DEFAULT));
 			dataString += ",";
 		}
 		else
 		{
-			/* Print the current millis value as system timestamp */
-			dataString += String(millis());
+			/* Print the system uptime (sleep included) as timestamp */
+			dataString += String(BAGAClock::getMsString(timestampString));
 			dataString += ",";
 		}
 		
@@ -345,8 +359,9 @@ void loop() {
 
 	if(clock.isInitialized() == true)
 	{
-		/* Update the emulated date and time */
-		clock.addTime(0,0,0,0,0,(int)(millis()-timestamp)/1000);
-		timestamp = millis();
+		/* Update the emulated date and time (BAGAClock includes the sleep time) */
+		elapsedS = (BAGAClock::nowMs() - timestamp) / 1000;
+		clock.addSeconds(elapsedS); // Drift correction included
+		timestamp += (unsigned long long) elapsedS * 1000; // Keep the fraction of a second
 	}
 }
@@ -0,0 +1,344 @@
+#include <Wire.h>
+#include <BMP280.h>
+#include <Si7020.h>
+#include <BAGA.h>
+#include <SPI.h>
+#include <SdFat.h>
+
+/************************************************************************
+* BAGA A3
+* Raw Data Logger Example 
+*
+* This example reads data periodically, saves only the uncompensated
+* sensor words to the MicroSD Card and enters in sleep mode. No
+* compensation math runs on the board: the BMP280 calibration data is
+* written once at the top of each new log file and the host decoder
+* (extras/RawDecoder) converts the file to physical units.
+* The timestamp is the system uptime in milliseconds, sleep time
+* included (BAGAClock).
+*
+* HW Compatibility:
+* 	Schematic: A2
+*   PCB: A3/A4
+*************************************************************************/
+
+/**********************
+ * BAGA Configuration *
+ **********************/
+
+/* Enable debug */
+//#define BAGA_DEBUG		
+
+/* Log filename */
+char logFileName[] = "raw.csv";
+
+/* Configuration filename (used for the SWClock) */
+char configFilename[] = "config.txt";
+
+/* Sensor reading periodicity in minutes */
+unsigned long ReadIntervalM = 1;
+
+/* Sensor reading periodicity in seconds */
+unsigned long ReadIntervalS = (ReadIntervalM * 60);
+
+/* Log file header */
+char strDataString[] = "Timestamp,Press_Raw,Temp_Press_Raw,Hum_Rel_Raw,Temp_Raw,Rad_Sol_Adc,Vol_Bat_Adc";
+
+/* Calibration header tag */
+char strCalibrationTag[] = "#CAL";
+
+/* Select the desired debug serial port */
+/* Serial (USB-CDC) or Serial1 (J3 connector on board) */
+#if defined(BAGA_DEBUG)
+#define DebugSerial  	Serial
+#endif
+
+/*************
+ * Variables *
+ *************/
+
+/* Macros */
+#define LF					0x0A
+#define CR					0x0D
+#define MAX_LINE_LENGTH		31
+
+/* Classes objects */
+BAGA baga; 									// BAGA instance
+SdFat sd;									// SD card instance
+SdFile logFile;								// Log file
+SdFile configFile;							// Configuration file
+
+/* Globals */
+BMP280CalibrationData calibration;			// BMP280 calibration data
+char fileString[MAX_LINE_LENGTH + 1];		// String to read each line from file
+char timestampString[BAGA_CLOCK_STRING_LENGTH];	// Timestamp (BAGAClock milliseconds)
+unsigned long ID = 0; 						// Measurements counter
+
+/* Strings */
+#if defined(BAGA_DEBUG)
+char strOpeningSd[27] = "Opening log file..........";
+char strOk[7] = "[ OK ]";
+char strFail[7] = "[FAIL]";
+#endif
+
+/*************
+ * FUNCTIONS *
+ *************/
+int readLine(SdFile *file, char * outputBuffer)
+{
+	int data;
+	int count = 0;
+
+	/* Read next char */
+	data = (*file).read();
+
+	/* Check if is the end of the file */
+	if (data == EOF)
+	{
+		return EOF;
+	}
+	
+	/* Read until an EOF, end of line or carriage return is reached */
+	while((data != EOF) && (data != LF) && (data != CR))
+	{
+		outputBuffer[count++] = data;
+		data = (*file).read();
+	}
+
+	outputBuffer[count] = '\0';
+
+	return count;
+}
+
+/*********
+ * SETUP *
+ *********/
+
+void setup() {
+	// put your setup code here, to run once:
+	TXLED1;  // Disable TX LED to Save Power
+    RXLED1;	 // Disable RX LED to Save Power
+
+#if defined(BAGA_DEBUG)
+	DebugSerial.begin(9600);
+	//while(!DebugSerial);
+#endif
+
+	if (baga.begin())
+	{
+		#if defined(BAGA_DEBUG)
+		DebugSerial.println(strFail);
+		#endif
+		baga.blinkForever(3);
+	}
+	else
+	{
+		#if defined(BAGA_DEBUG)
+		DebugSerial.println(strOk);
+		#endif
+	}
+
+	/* Initialize SD card (SPI @ 10MHz)*/
+	if (!sd.begin(BAGA_SDCARD_CS_PIN, SD_SCK_MHZ(10)))
+	{
+		#if defined(BAGA_DEBUG)
+		sd.initErrorHalt();
+		#endif
+		baga.blinkForever(4);
+	}
+	
+	/* Open configuration file */
+	if (!configFile.open(configFilename, O_READ))
+	{
+		#if defined(BAGA_DEBUG)
+		sd.errorHalt("Error opening config file");
+		#endif
+		baga.blinkForever(5);
+	}
+	else
+	{
+		int data;
+		int count = 0;
+	
+		/* Read lines from file */
+		while((count = readLine(&configFile, fileString)) != EOF)
+		{	
+			/* Check the number of bytes of each line */
+			if (count > 0)
+			{
+				if ((fileString[0] == 'P') ||  (fileString[0] == 'p'))
+				{
+					/* convert the string */
+					ReadIntervalM = (unsigned long)atol(fileString+1);
+					
+					/* Read interval must be at least 1 minute */
+					if(ReadIntervalM < 1)
+					{
+						ReadIntervalM = 1;
+					}
+
+					/* Calculate the new interval value in seconds */
+					ReadIntervalS = (ReadIntervalM * 60);
+
+					#if defined(BAGA_DEBUG)
+					DebugSerial.print("Period: ");
+					DebugSerial.print(fileString+1);
+					DebugSerial.print("Converted value: ");
+					DebugSerial.println(ReadIntervalM, DEC);
+					#endif
+				}
+			}
+		}
+		
+		/* Close the file */
+		configFile.close();
+
+		#if defined(BAGA_DEBUG)
+		Serial.println(configString);
+		#endif
+	}
+
+	/* Open log file */
+	if (!logFile.open(logFileName, O_WRITE | O_CREAT | O_APPEND | O_AT_END))
+	{
+		#if defined(BAGA_DEBUG)
+		sd.errorHalt("Error opening file");
+		#endif
+		baga.blinkForever(6);
+	}
+
+	/* Print the calibration and column headers only once per file */
+	if (logFile.fileSize() == 0)
+	{
+		baga.readCalibrationData(&calibration);
+		
+		logFile.print(strCalibrationTag);
+		logFile.print(",");
+		logFile.print(calibration.T1);
+		logFile.print(",");
+		logFile.print(calibration.T2);
+		logFile.print(",");
+		logFile.print(calibration.T3);
+		logFile.print(",");
+		logFile.print(calibration.P1);
+		logFile.print(",");
+		logFile.print(calibration.P2);
+		logFile.print(",");
+		logFile.print(calibration.P3);
+		logFile.print(",");
+		logFile.print(calibration.P4);
+		logFile.print(",");
+		logFile.print(calibration.P5);
+		logFile.print(",");
+		logFile.print(calibration.P6);
+		logFile.print(",");
+		logFile.print(calibration.P7);
+		logFile.print(",");
+		logFile.print(calibration.P8);
+		logFile.print(",");
+		logFile.println(calibration.P9);
+		
+		logFile.println(strDataString); // Print to file
+	}
+
+	/* Close the file */
+	logFile.close();
+
+	#if defined(BAGA_DEBUG)
+	DebugSerial.println(strDataString); // Print to the serial port
+	#endif
+
+	/* Blink all the LEDs to signal the correct setup */
+	TXLED0;
+	RXLED0;
+	baga.setLedOn();
+	delay(200);
+	TXLED1;
+	RXLED1;
+	baga.setLedOff();
+	delay(200);
+	TXLED0;
+	RXLED0;
+	baga.setLedOn();
+	delay(200);
+	TXLED1;
+	RXLED1;
+	baga.setLedOff();
+}
+
+/*************
+ * MAIN LOOP *
+ *************/
+
+void loop() {
+	// put your main code here, to run repeatedly:
+
+	/* Disable LEDs to save power */
+	TXLED1;
+    RXLED1;
+
+	/* Turn system LED on */
+	baga.setLedOn(); // Turn LED on to indicate that a measurement is in progress
+	
+	/* Read the sensors (raw words only) */
+	baga.readSensorsRaw();
+	
+	/* Turn system LED off */
+	baga.setLedOff();
+	
+	/* Open log file */
+	if (!logFile.open(logFileName, O_WRITE | O_CREAT | O_APPEND | O_AT_END))
+	{
+		#if defined(BAGA_DEBUG)
+		DebugSerial.println("errorHalt");
+		sd.errorHalt("Error opening file");
+		#endif
+		baga.blinkForever(7);
+	}
+	else
+	{
+		String dataString = "";
+
+		/* Print the system uptime (sleep included) as timestamp */
+		dataString += String(BAGAClock::getMsString(timestampString));
+		dataString += ",";
+		
+		/* Build the string with the raw values from the sensors */
+		
+		dataString += String(baga.readRawPressure());
+		dataString += ",";
+		dataString += String(baga.readRawPressureTemperature());
+		dataString += ",";
+		
+		dataString += String(baga.readRawRelHumidity());
+		dataString += ",";
+		dataString += String(baga.readRawTemperature());
+		dataString += ",";
+				
+		dataString += String(baga.readRawSolarRadiation()); // Oversampled, 0 to BAGA_ADC_FULL_SCALE
+		dataString += ",";
+		
+		dataString += String(baga.readRawBatteryVoltage());
+		
+		/* Increment measurements counter */
+		ID++;
+
+		#if !defined(BAGA_DEBUG)
+		Serial1.print("Data: ");
+		Serial1.println(dataString);
+		#endif
+		
+		/* Print all the values to the log file */
+		logFile.println(dataString);
+
+		/* Close the file */
+		logFile.close();
+
+		#if defined(BAGA_DEBUG)
+		DebugSerial.println(dataString); // Print to the serial port	
+		#endif
+	}
+
+	/* Enter sleep mode to save power */
+    baga.sleep(ReadIntervalS*1000, ADC_OFF);
+}
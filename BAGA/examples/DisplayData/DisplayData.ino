@@ -73,6 +73,7 @@ void setup() {
 
 void loop() {
 	// put your main code here, to run repeatedly:
+	char timestampString[BAGA_CLOCK_STRING_LENGTH];
 	
 	DebugSerial.println("################################");
 	
@@ -81,7 +82,7 @@ void loop() {
 	baga.setLedOff(); // Turn LED off
 	
 	DebugSerial.print("Timestamp: ");
-	DebugSerial.println(millis());
+	DebugSerial.println(BAGAClock::getMsString(timestampString));
 	
 	DebugSerial.print("Temperature (C):        ");
 	DebugSerial.println(baga.readTemperatureC());
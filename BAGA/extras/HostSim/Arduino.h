@@ -0,0 +1,109 @@
+/*
+* File:    Arduino.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - Arduino core stand-in
+*
+* Just enough of the Arduino core to compile the BAGA, BMP280, Si7020,
+* I2CBus and SWClock libraries on a host computer. Time is virtual: it
+* only advances through delay(), sleep, simulated bus traffic and a small
+* cost for each millis()/micros() call (so polling loops terminate).
+***/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+typedef uint8_t		byte;
+typedef bool		boolean;
+
+#define		HIGH							1
+#define		LOW								0
+#define		INPUT							0
+#define		OUTPUT							1
+#define		INPUT_PULLUP					2
+
+// ATmega32u4 (Leonardo) analog pins
+#define		A0								18
+#define		A1								19
+#define		A2								20
+#define		A3								21
+#define		A4								22
+#define		A5								23
+
+#define		F_CPU							16000000UL
+
+// Watchdog control register (only the interrupt enable bit is simulated, see LowPower.h)
+#define		WDIE							6
+extern volatile uint8_t WDTCSR;
+
+#define		HOST_PIN_COUNT					32
+#define		HOST_CALL_COST_US				1 // Virtual time taken by each millis()/micros() call
+
+// Program memory is ordinary memory on the host
+#define		PROGMEM
+#define		PSTR(s)							(s)
+#define		F(s)							(s)
+#define		pgm_read_byte(p)				(*(const uint8_t *)(p))
+#define		pgm_read_word(p)				(*(const uint16_t *)(p))
+#define		pgm_read_dword(p)				(*(const uint32_t *)(p))
+#define		memcpy_P						memcpy
+#define		strcpy_P						strcpy
+
+#ifndef min
+#define		min(a,b)						((a) < (b) ? (a) : (b))
+#endif
+#ifndef max
+#define		max(a,b)						((a) > (b) ? (a) : (b))
+#endif
+#define		constrain(amt,low,high)			((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long	millis(void);
+unsigned long	micros(void);
+void			delay(unsigned long ms);
+void			delayMicroseconds(unsigned int us);
+void			pinMode(uint8_t pin, uint8_t mode);
+void			digitalWrite(uint8_t pin, uint8_t value);
+int				digitalRead(uint8_t pin);
+int				analogRead(uint8_t pin);
+
+/* Host only: virtual clock and pin levels */
+void				hostAdvanceUs(unsigned long long us); // Advance the virtual clock
+unsigned long long	hostGetTimeUs(void); // Virtual time since start (64-bit, no wrap)
+void				hostSetAnalogValue(uint8_t pin, int value); // Value returned by analogRead(pin)
+int					hostGetDigitalValue(uint8_t pin); // Last value written with digitalWrite(pin)
+
+
+/* Serial port printing to stdout */
+class HostSerial
+{
+	public:
+		void	begin(unsigned long baud) { (void) baud; }
+		operator bool() { return true; }
+		size_t	write(uint8_t c) { return (fputc(c, stdout) == EOF) ? 0 : 1; }
+		size_t	print(const char *s) { return (size_t) printf("%s", s); }
+		size_t	print(char c) { return write((uint8_t) c); }
+		size_t	print(int v) { return (size_t) printf("%d", v); }
+		size_t	print(unsigned int v) { return (size_t) printf("%u", v); }
+		size_t	print(long v) { return (size_t) printf("%ld", v); }
+		size_t	print(unsigned long v) { return (size_t) printf("%lu", v); }
+		size_t	print(double v, int digits = 2) { return (size_t) printf("%.*f", digits, v); }
+		size_t	println(void) { return write('\n'); }
+		template<class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+		size_t	println(double v, int digits) { size_t n = print(v, digits); return n + println(); }
+		void	flush(void) { fflush(stdout); }
+};
+
+extern HostSerial Serial;
+extern HostSerial Serial1;
+
+#endif
@@ -0,0 +1,193 @@
+/*
+* File:    HostArduino.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - Arduino core stand-in (virtual clock and pins)
+***/
+
+#include "Arduino.h"
+#include "LowPower.h"
+#include "avr/wdt.h"
+
+HostSerial Serial;
+HostSerial Serial1;
+LowPowerClass LowPower;
+
+static unsigned long long hostTimeUs = 0; // Virtual time
+static unsigned long long hostTimer0StoppedUs = 0; // Time in power down (millis() and micros() do not count it)
+static int hostAnalogValues[HOST_PIN_COUNT];
+static int hostDigitalValues[HOST_PIN_COUNT];
+
+
+void hostAdvanceUs(unsigned long long us)
+{
+	hostTimeUs += us;
+}
+
+
+unsigned long long hostGetTimeUs(void)
+{
+	return hostTimeUs;
+}
+
+
+unsigned long millis(void)
+{
+	hostTimeUs += HOST_CALL_COST_US;
+
+	return (unsigned long) ((hostTimeUs - hostTimer0StoppedUs) / 1000);
+}
+
+
+unsigned long micros(void)
+{
+	hostTimeUs += HOST_CALL_COST_US;
+
+	return (unsigned long) (hostTimeUs - hostTimer0StoppedUs);
+}
+
+
+void delay(unsigned long ms)
+{
+	hostTimeUs += (unsigned long long) ms * 1000;
+}
+
+
+void delayMicroseconds(unsigned int us)
+{
+	hostTimeUs += us;
+}
+
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	(void) pin;
+	(void) mode;
+}
+
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if (pin < HOST_PIN_COUNT)
+	{
+		hostDigitalValues[pin] = value;
+	}
+}
+
+
+int digitalRead(uint8_t pin)
+{
+	return (pin < HOST_PIN_COUNT) ? hostDigitalValues[pin] : LOW;
+}
+
+
+int hostGetDigitalValue(uint8_t pin)
+{
+	return digitalRead(pin);
+}
+
+
+int analogRead(uint8_t pin)
+{
+	hostTimeUs += 104; // 13 ADC clocks at 125 kHz
+
+	return (pin < HOST_PIN_COUNT) ? hostAnalogValues[pin] : 0;
+}
+
+
+void hostSetAnalogValue(uint8_t pin, int value)
+{
+	if (pin < HOST_PIN_COUNT)
+	{
+		hostAnalogValues[pin] = value;
+	}
+}
+
+
+/***
+* Function: hostWatchdogPeriodUs(period_t period)
+* Description: Real watchdog period: 2K cycles of the 128 kHz oscillator
+*              (16 ms, labelled 15 ms) doubled per step, times the
+*              oscillator error set with hostSetWatchdogScale()
+***/
+static double hostWatchdogScale = 1.0;
+static unsigned long long hostWatchdogExpireUs; // Armed watchdog interrupt (WDIE set)
+
+volatile uint8_t WDTCSR;
+
+void hostSetWatchdogScale(double scale)
+{
+	hostWatchdogScale = scale;
+}
+
+void wdt_disable(void)
+{
+	WDTCSR &= ~(1 << WDIE);
+}
+
+static unsigned long long hostWatchdogPeriodUs(period_t period)
+{
+	return (unsigned long long) ((16000ULL << period) * hostWatchdogScale + 0.5);
+}
+
+
+/***
+* Function: powerDown(period_t period, adc_t adc, bod_t bod)
+* Description: Sleep for the watchdog period, plus the crystal start-up
+*              time (16K clock cycles) on wake-up. Timer0 is stopped:
+*              millis() and micros() do not count this time.
+***/
+void LowPowerClass::powerDown(period_t period, adc_t adc, bod_t bod)
+{
+	(void) adc;
+	(void) bod;
+
+	WDTCSR &= ~(1 << WDIE);
+	if (period < SLEEP_FOREVER)
+	{
+		hostTimeUs += hostWatchdogPeriodUs(period) + (16384ULL * 1000000) / F_CPU;
+		hostTimer0StoppedUs += hostWatchdogPeriodUs(period) + (16384ULL * 1000000) / F_CPU;
+	}
+}
+
+
+/***
+* Function: idle(period_t period, ...)
+* Description: Idle until the next Timer0 overflow (Arduino core tick every
+*              1024 us) or the watchdog interrupt, whichever comes first.
+*              Like the LowPower library, a watchdog period arms the
+*              watchdog interrupt, which clears WDIE when it fires.
+***/
+void LowPowerClass::idle(period_t period, adc_t adc, timer4_t timer4, timer3_t timer3, timer1_t timer1,
+						 timer0_t timer0, spi_t spi, usart1_t usart1, twi_t twi, usb_t usb)
+{
+	unsigned long long timer0Us = hostTimeUs - hostTimer0StoppedUs;
+	unsigned long long wakeUs = hostTimeUs + ((timer0Us / 1024 + 1) * 1024 - timer0Us); // Next Timer0 overflow
+
+	(void) adc; (void) timer4; (void) timer3; (void) timer1;
+	(void) spi; (void) usart1; (void) twi; (void) usb;
+
+	if (period < SLEEP_FOREVER)
+	{
+		hostWatchdogExpireUs = hostTimeUs + hostWatchdogPeriodUs(period);
+		WDTCSR |= (1 << WDIE);
+	}
+
+	if (timer0 == TIMER0_OFF)
+	{
+		wakeUs = (unsigned long long) -1; // Only the watchdog wakes the device
+	}
+	if (((WDTCSR & (1 << WDIE)) != 0) && (hostWatchdogExpireUs <= wakeUs))
+	{
+		wakeUs = (hostWatchdogExpireUs > hostTimeUs) ? hostWatchdogExpireUs : hostTimeUs;
+		WDTCSR &= ~(1 << WDIE); // Watchdog interrupt
+	}
+	if (wakeUs != (unsigned long long) -1)
+	{
+		hostTimeUs = wakeUs;
+	}
+}
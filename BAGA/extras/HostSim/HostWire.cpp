@@ -0,0 +1,248 @@
+/*
+* File:    HostWire.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - Wire library stand-in
+***/
+
+#include "Wire.h"
+
+TwoWire Wire;
+
+
+TwoWire::TwoWire()
+{
+	_deviceCount = 0;
+	_clockHz = HOST_WIRE_DEFAULT_CLOCK_HZ;
+	_timeoutUs = 0;
+	_timeoutFlag = false;
+	_txAddress = 0;
+	_txLength = 0;
+	_rxLength = 0;
+	_rxIndex = 0;
+	resetStats();
+}
+
+
+void TwoWire::begin(void)
+{
+	_clockHz = HOST_WIRE_DEFAULT_CLOCK_HZ;
+}
+
+
+void TwoWire::setClock(uint32_t clock)
+{
+	_clockHz = clock;
+}
+
+
+void TwoWire::setWireTimeout(uint32_t timeout, bool resetWithTimeout)
+{
+	(void) resetWithTimeout;
+
+	_timeoutUs = timeout;
+}
+
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+	_txAddress = address;
+	_txLength = 0;
+}
+
+
+size_t TwoWire::write(uint8_t value)
+{
+	if (_txLength >= BUFFER_LENGTH)
+	{
+		return 0;
+	}
+
+	_txBuffer[_txLength++] = value;
+
+	return 1;
+}
+
+
+size_t TwoWire::write(const uint8_t *data, size_t length)
+{
+	size_t count;
+
+	for (count = 0; count < length; count++)
+	{
+		if (write(data[count]) == 0)
+		{
+			break;
+		}
+	}
+
+	return count;
+}
+
+
+/***
+* Function: endTransmission(bool sendStop)
+* Returns: 0 success, 2 address NACK, 3 data NACK (same codes as Wire)
+***/
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+	SimI2CDevice *device = findDevice(_txAddress);
+
+	_stats.transactions++;
+
+	if (device == 0)
+	{
+		_stats.nacks++;
+		busTime(0, true);
+		return 2;
+	}
+
+	busTime(_txLength, sendStop);
+	_stats.bytesWritten += _txLength;
+
+	if (!device->write(_txBuffer, _txLength, sendStop))
+	{
+		_stats.nacks++;
+		return 3;
+	}
+
+	return 0;
+}
+
+
+/***
+* Function: requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+* Returns: Number of bytes received (0 if the address was not acknowledged
+*          or the Wire timeout expired)
+***/
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+{
+	SimI2CDevice *device = findDevice(address);
+	unsigned long stretchUs;
+
+	_rxLength = 0;
+	_rxIndex = 0;
+	_stats.transactions++;
+
+	if (quantity > BUFFER_LENGTH)
+	{
+		quantity = BUFFER_LENGTH;
+	}
+
+	if (device == 0)
+	{
+		_stats.nacks++;
+		busTime(0, true);
+		return 0;
+	}
+
+	stretchUs = device->readStretchUs();
+	if ((_timeoutUs != 0) && (stretchUs > _timeoutUs))
+	{
+		// The master gives up and resets the bus
+		hostAdvanceUs(_timeoutUs);
+		_stats.busTimeUs += _timeoutUs;
+		_stats.timeouts++;
+		_timeoutFlag = true;
+		return 0;
+	}
+	hostAdvanceUs(stretchUs);
+	_stats.busTimeUs += stretchUs;
+
+	if (!device->read(_rxBuffer, quantity))
+	{
+		_stats.nacks++;
+		busTime(0, true);
+		return 0;
+	}
+
+	busTime(quantity, sendStop != 0);
+	_stats.bytesRead += quantity;
+	_rxLength = quantity;
+
+	return quantity;
+}
+
+
+int TwoWire::available(void)
+{
+	return _rxLength - _rxIndex;
+}
+
+
+int TwoWire::read(void)
+{
+	if (_rxIndex >= _rxLength)
+	{
+		return -1;
+	}
+
+	return _rxBuffer[_rxIndex++];
+}
+
+
+int TwoWire::peek(void)
+{
+	if (_rxIndex >= _rxLength)
+	{
+		return -1;
+	}
+
+	return _rxBuffer[_rxIndex];
+}
+
+
+void TwoWire::attachDevice(SimI2CDevice *device)
+{
+	if (_deviceCount < HOST_WIRE_MAX_DEVICES)
+	{
+		_devices[_deviceCount++] = device;
+	}
+}
+
+
+void TwoWire::getStats(HostWireStats *stats)
+{
+	*stats = _stats;
+}
+
+
+void TwoWire::resetStats(void)
+{
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+
+SimI2CDevice *TwoWire::findDevice(uint8_t address)
+{
+	uint8_t i;
+
+	for (i = 0; i < _deviceCount; i++)
+	{
+		if (_devices[i]->getAddress() == address)
+		{
+			return _devices[i];
+		}
+	}
+
+	return 0;
+}
+
+
+/***
+* Function: busTime(unsigned int bytes, bool stop)
+* Description: START + address byte + data bytes (9 bit times each,
+*              ACK included) + STOP or repeated START
+***/
+void TwoWire::busTime(unsigned int bytes, bool stop)
+{
+	unsigned long bits = 1 + 9 * (1 + bytes) + (stop ? 1 : 0);
+	unsigned long long us = ((unsigned long long) bits * 1000000ULL + _clockHz - 1) / _clockHz;
+
+	hostAdvanceUs(us);
+	_stats.busTimeUs += us;
+}
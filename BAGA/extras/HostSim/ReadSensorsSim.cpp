@@ -0,0 +1,308 @@
+/*
+* File:    ReadSensorsSim.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - BAGA::readSensors() transaction report
+*
+* Runs BAGA::begin() and BAGA::readSensors() against the simulated
+* BMP280 and Si7020 and reports the I2C transactions, bytes and virtual
+* time of each call. Exits with 1 if a reading is wrong, readSensors()
+* takes longer than BAGA_READ_SENSORS_MAX_MS or readSensorsPipelined()
+* does not shorten the wake time, so it can be used as a regression test.
+*
+* Build and run (from this folder): make run
+* Usage: ReadSensorsSim [iterations]
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "SimBMP280.h"
+#include "SimSi7020.h"
+#include "BAGA.h"
+
+#define		SIM_EXPECTED_PRESSURE_PA			100658 // Datasheet example with 16-bit pressure (x1 oversampling)
+#define		SIM_EXPECTED_TEMPERATURE_C			25.0
+#define		SIM_EXPECTED_REL_HUMIDITY			50.0
+#define		SIM_EXPECTED_TEMPERATURE_CENTI_C	2500
+#define		SIM_EXPECTED_REL_HUMIDITY_CENTI		5000
+#define		SIM_TOLERANCE						0.05
+#define		SIM_EXPECTED_DEW_POINT_C			13.85 // 25 C, 50 %RH (Magnus formula)
+#define		SIM_EXPECTED_ABS_HUMIDITY			11.48 // g/m3
+#define		SIM_EXPECTED_HEAT_INDEX_F			76.75 // Simple formula (below 80 F)
+#define		SIM_STUCK_CONVERSION_US				1000000 // BMP280 conversion that outlasts any poll
+#define		SIM_SLEEP_MS						600000 // Logging interval
+#define		SIM_SLEEP_TOLERANCE_MS				50 // 0.01 %: a few us of timing overhead per 16 ms calibration
+#define		SIM_WATCHDOG_SCALE					1.08 // Watchdog oscillator 8 % slow
+#define		SIM_SOLAR_RADIATION_ADC				512
+#define		SIM_BATTERY_VOLTAGE_ADC				853
+#define		SIM_EXPECTED_BATTERY_MV				3752
+
+SimBMP280 simBMP280;
+SimSi7020 simSi7020;
+BAGA baga;
+Si7020 si7020; // Second handle on the simulated Si7020 for the driver checks
+
+
+/***
+* Function: printStats(const char *name, const HostWireStats *stats, unsigned long long durationUs)
+* Description: Print one line of the report
+***/
+static void printStats(const char *name, const HostWireStats *stats, unsigned long long durationUs)
+{
+	printf("%-12s %6lu %9lu %9lu %6lu %8lu %10llu %10llu\n", name, stats->transactions, stats->bytesWritten, stats->bytesRead,
+		stats->nacks, stats->timeouts, stats->busTimeUs, durationUs);
+}
+
+
+int main(int argc, char *argv[])
+{
+	HostWireStats stats;
+	BAGA::Sample sample;
+	unsigned long long start, duration, maxDuration = 0, sequentialDuration = 0;
+	unsigned long iterations = 1;
+	unsigned long slept = 0;
+	unsigned long long clockStart, clockElapsed, realStart, realElapsed, measuredMs = 0;
+	char clockString[BAGA_CLOCK_STRING_LENGTH];
+	unsigned long i;
+	int failures = 0;
+
+	if (argc > 1)
+	{
+		iterations = strtoul(argv[1], NULL, 10);
+	}
+
+	Wire.attachDevice(&simBMP280);
+	Wire.attachDevice(&simSi7020);
+	hostSetAnalogValue(BAGA_SOLAR_RADIATION_PIN, SIM_SOLAR_RADIATION_ADC);
+	hostSetAnalogValue(BAGA_BATTERY_VOLTAGE_PIN, SIM_BATTERY_VOLTAGE_ADC);
+
+	printf("%-12s %6s %9s %9s %6s %8s %10s %10s\n", "Call", "Trans", "BytesOut", "BytesIn", "NACKs", "Timeouts", "BusUs", "TotalUs");
+
+	Wire.resetStats();
+	start = hostGetTimeUs();
+	if (baga.begin() != 0)
+	{
+		printf("begin() failed\n");
+		failures++;
+	}
+	Wire.getStats(&stats);
+	printStats("begin", &stats, hostGetTimeUs() - start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		Wire.resetStats();
+		start = hostGetTimeUs();
+		if (baga.readSensors() != 0)
+		{
+			printf("readSensors() failed\n");
+			failures++;
+		}
+		duration = hostGetTimeUs() - start;
+		Wire.getStats(&stats);
+
+		if (duration > maxDuration)
+		{
+			maxDuration = duration;
+		}
+
+		if (i == 0)
+		{
+			printStats("readSensors", &stats, duration);
+			sequentialDuration = duration;
+		}
+
+		delay(1000); // Logging interval
+	}
+
+	// Both sensors converting at the same time: same readings in less time
+	Wire.resetStats();
+	start = hostGetTimeUs();
+	if (baga.readSensorsPipelined() != 0)
+	{
+		printf("readSensorsPipelined() failed\n");
+		failures++;
+	}
+	duration = hostGetTimeUs() - start;
+	Wire.getStats(&stats);
+	printStats("pipelined", &stats, duration);
+	if ((duration >= sequentialDuration) || (duration > (unsigned long long) BAGA_READ_SENSORS_PIPELINED_MAX_MS * 1000)
+		|| (baga.readWakeDurationUs() > duration))
+	{
+		printf("FAIL: readSensorsPipelined() wake time\n");
+		failures++;
+	}
+	printf("Wake time    %lu us (readSensors %llu us)\n", baga.readWakeDurationUs(), sequentialDuration);
+	
+	// Stuck BMP280: readSensorsPipelined() gives up within BAGA_READ_SENSORS_PIPELINED_MAX_MS
+	simBMP280.setConversionDelayUs(SIM_STUCK_CONVERSION_US);
+	Wire.resetStats();
+	start = hostGetTimeUs();
+	i = baga.readSensorsPipelined();
+	duration = hostGetTimeUs() - start;
+	Wire.getStats(&stats);
+	printStats("BMP280 stuck", &stats, duration);
+	simBMP280.setConversionDelayUs(0);
+	if ((i == 0) || (duration > (unsigned long long) BAGA_READ_SENSORS_PIPELINED_MAX_MS * 1000)
+		|| ((duration - stats.busTimeUs) > (BAGA_PIPELINE_CONVERSION_MAX_US + (BAGA_PIPELINE_POLL_TIMEOUT_MS * 1000UL)))
+		|| (baga.readSensorsPipelined() != 0)) // Next measurement starts a new conversion
+	{
+		printf("FAIL: readSensorsPipelined() timeout\n");
+		failures++;
+	}
+	
+	// Several samples per channel reduced to one value
+	for (i = BAGA_FILTER_MEAN; i <= BAGA_FILTER_TRIMMED_MEAN; i++)
+	{
+		Wire.resetStats();
+		start = hostGetTimeUs();
+		measuredMs = BAGAClock::nowMs();
+		if ((baga.readSensors(5, i) != 0) || (baga.readTemperatureCentiC() != SIM_EXPECTED_TEMPERATURE_CENTI_C)
+			|| (baga.readRelHumidityCenti() != SIM_EXPECTED_REL_HUMIDITY_CENTI) || (baga.readAbsPressurePa() != SIM_EXPECTED_PRESSURE_PA)
+			|| (baga.readBatteryVoltage() != SIM_EXPECTED_BATTERY_MV) || (si7020.getResolution() != SI7020_RES_RH12_TEMP14))
+		{
+			printf("FAIL: readSensors(5, %lu)\n", i);
+			failures++;
+		}
+		duration = hostGetTimeUs() - start;
+		Wire.getStats(&stats);
+		if (i == BAGA_FILTER_MEDIAN)
+		{
+			printStats("median of 5", &stats, duration);
+		}
+	}
+	
+	// Si7020 No Hold Master measurement: the bus stays free during the conversion
+	Wire.resetStats();
+	start = hostGetTimeUs();
+	i = 0;
+	if (si7020.startRelHumidity() == 0)
+	{
+		while ((si7020.fetch() != 0) && (i < 1000))
+		{
+			delayMicroseconds(1000);
+			i++;
+		}
+	}
+	duration = hostGetTimeUs() - start;
+	Wire.getStats(&stats);
+	printStats("Si7020 async", &stats, duration);
+	if ((i >= 1000) || (fabs(si7020.getRelHumidity() - SIM_EXPECTED_REL_HUMIDITY) > SIM_TOLERANCE))
+	{
+		printf("FAIL: Si7020 No Hold Master measurement\n");
+		failures++;
+	}
+
+	// Lowest resolution: the conversion must end within the advertised time
+	si7020.setResolution(SI7020_RES_RH08_TEMP12);
+	Wire.resetStats();
+	start = hostGetTimeUs();
+	i = 0;
+	if (si7020.startRelHumidity() == 0)
+	{
+		while ((si7020.fetch() != 0) && (i < 1000))
+		{
+			delayMicroseconds(100);
+			i++;
+		}
+	}
+	duration = hostGetTimeUs() - start;
+	Wire.getStats(&stats);
+	printStats("Si7020 RH8", &stats, duration);
+	if ((si7020.getResolution() != SI7020_RES_RH08_TEMP12) || (duration > si7020.getConversionTimeUs() + 1000UL))
+	{
+		printf("FAIL: Si7020 resolution\n");
+		failures++;
+	}
+
+	// Software reset: POR resolution again once the device answers
+	if ((si7020.reset() != 0) || (si7020.getResolution() != SI7020_RES_RH12_TEMP14))
+	{
+		printf("FAIL: Si7020 reset\n");
+		failures++;
+	}
+
+	// Calibrated sleep: the second call uses the filtered watchdog period
+	hostSetWatchdogScale(SIM_WATCHDOG_SCALE);
+	clockStart = BAGAClock::nowMs();
+	realStart = hostGetTimeUs();
+	for (i = 0; i < 2; i++)
+	{
+		start = hostGetTimeUs();
+		slept = baga.sleep(SIM_SLEEP_MS, ADC_OFF);
+		duration = hostGetTimeUs() - start;
+		
+		if ((llabs((long long) (duration / 1000) - SIM_SLEEP_MS) > SIM_SLEEP_TOLERANCE_MS) || (llabs((long long) (duration / 1000) - slept) > SIM_SLEEP_TOLERANCE_MS))
+		{
+			printf("FAIL: sleep(%lu) took %llu us, reported %lu ms\n", (unsigned long) SIM_SLEEP_MS, duration, slept);
+			failures++;
+		}
+	}
+	printf("\nSleep        %lu ms requested, %llu us slept, %lu ms reported\n", (unsigned long) SIM_SLEEP_MS, duration, slept);
+	
+	// BAGAClock counts the power down time that millis() misses
+	clockElapsed = BAGAClock::nowMs() - clockStart;
+	realElapsed = (hostGetTimeUs() - realStart) / 1000;
+	printf("Clock        %llu ms elapsed, BAGAClock %llu ms (%s ms since start-up)\n", realElapsed, clockElapsed, BAGAClock::getMsString(clockString));
+	if ((clockElapsed > realElapsed + 2 * SIM_SLEEP_TOLERANCE_MS) || (clockElapsed + 2 * SIM_SLEEP_TOLERANCE_MS < realElapsed)) // Two sleeps
+	{
+		printf("FAIL: BAGAClock\n");
+		failures++;
+	}
+	
+	printf("Temperature  %.2f C\n", baga.readTemperatureC());
+	printf("Humidity     %.2f %%\n", baga.readRelHumidity());
+	printf("Pressure     %ld Pa\n", baga.readAbsPressurePa());
+	printf("Dew point    %.2f C, %.2f g/m3, heat index %.2f F\n", baga.readDewPointC(), baga.readAbsHumidity(), baga.readHeatIndexF());
+	printf("Worst case   %llu us of %lu us allowed (%lu calls)\n", maxDuration, (unsigned long) BAGA_READ_SENSORS_MAX_MS * 1000, iterations);
+
+	if (baga.readAbsPressurePa() != SIM_EXPECTED_PRESSURE_PA)
+	{
+		printf("FAIL: pressure\n");
+		failures++;
+	}
+	if (fabs(baga.readTemperatureC() - SIM_EXPECTED_TEMPERATURE_C) > SIM_TOLERANCE)
+	{
+		printf("FAIL: temperature\n");
+		failures++;
+	}
+	if (fabs(baga.readRelHumidity() - SIM_EXPECTED_REL_HUMIDITY) > SIM_TOLERANCE)
+	{
+		printf("FAIL: relative humidity\n");
+		failures++;
+	}
+	if ((baga.readTemperatureCentiC() != SIM_EXPECTED_TEMPERATURE_CENTI_C) || (baga.readRelHumidityCenti() != SIM_EXPECTED_REL_HUMIDITY_CENTI))
+	{
+		printf("FAIL: fixed point temperature / relative humidity\n");
+		failures++;
+	}
+	if ((fabs(baga.readDewPointC() - SIM_EXPECTED_DEW_POINT_C) > SIM_TOLERANCE) || (fabs(baga.readAbsHumidity() - SIM_EXPECTED_ABS_HUMIDITY) > SIM_TOLERANCE)
+		|| (fabs(baga.readHeatIndexF() - SIM_EXPECTED_HEAT_INDEX_F) > SIM_TOLERANCE))
+	{
+		printf("FAIL: derived metrics\n");
+		failures++;
+	}
+	sample = baga.readSample();
+	if ((sizeof(BAGA::Sample) != 16) || (sample.pressurePa != SIM_EXPECTED_PRESSURE_PA)
+		|| (sample.temperatureCentiC != SIM_EXPECTED_TEMPERATURE_CENTI_C) || (sample.relHumidityCenti != SIM_EXPECTED_REL_HUMIDITY_CENTI)
+		|| (sample.solarRadiationAdc != (SIM_SOLAR_RADIATION_ADC << BAGA_ADC_EXTRA_BITS)) || (sample.batteryVoltageMv != SIM_EXPECTED_BATTERY_MV)
+		|| (baga.readRawSolarRadiation() != (SIM_SOLAR_RADIATION_ADC << BAGA_ADC_EXTRA_BITS)) || (baga.readRawBatteryVoltage() != (SIM_BATTERY_VOLTAGE_ADC << BAGA_ADC_EXTRA_BITS))
+		|| ((uint32_t) (sample.timestampMs - (uint32_t) measuredMs) > 1)) // Time of the last readSensors(), not of the snapshot
+	{
+		printf("FAIL: sample snapshot\n");
+		failures++;
+	}
+	if (maxDuration > (unsigned long long) BAGA_READ_SENSORS_MAX_MS * 1000)
+	{
+		printf("FAIL: readSensors() took longer than BAGA_READ_SENSORS_MAX_MS\n");
+		failures++;
+	}
+
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+/*
+* File:    SimBMP280.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - BMP280 register model
+***/
+
+#include "SimBMP280.h"
+
+#define		SIM_BMP280_REG_CALIB_00				0x88
+#define		SIM_BMP280_REG_ID					0xD0
+#define		SIM_BMP280_REG_RESET				0xE0
+#define		SIM_BMP280_REG_STATUS				0xF3
+#define		SIM_BMP280_REG_CTRL_MEAS			0xF4
+#define		SIM_BMP280_REG_CONFIG				0xF5
+#define		SIM_BMP280_REG_PRESS_MSB			0xF7
+#define		SIM_BMP280_REG_TEMP_MSB				0xFA
+
+#define		SIM_BMP280_RESET_VALUE				0xB6
+#define		SIM_BMP280_STATUS_MEASURING			0x08
+
+// Datasheet example calibration (section 8.2): T1..T3, P1..P9
+static const unsigned short simBMP280Calibration[12] = { 27504, 26435, (unsigned short) -1000, 36477, (unsigned short) -10685, 3024, 2855, 140, (unsigned short) -7, 15500, (unsigned short) -14600, 6000 };
+
+// Normal Mode standby times in us (datasheet table 11)
+static const unsigned long simBMP280StandbyUs[8] = { 500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000 };
+
+
+SimBMP280::SimBMP280(uint8_t address) : SimI2CDevice(address)
+{
+	_rawTemperature = SIM_BMP280_RAW_TEMPERATURE;
+	_rawPressure = SIM_BMP280_RAW_PRESSURE;
+	_measurementCount = 0;
+	_conversionDelayUs = 0;
+	reset();
+}
+
+
+/***
+* Function: write(const uint8_t *data, uint8_t length, bool stop)
+* Description: I2C write: register address followed by data. Writes are
+*              register/data pairs (no auto-increment, datasheet 5.2.1).
+***/
+bool SimBMP280::write(const uint8_t *data, uint8_t length, bool stop)
+{
+	uint8_t i;
+
+	(void) stop;
+
+	update();
+
+	if (length == 0)
+	{
+		return true; // Address only
+	}
+
+	for (i = 0; (i + 1) < length; i += 2)
+	{
+		writeRegister(data[i], data[i + 1]);
+	}
+
+	_pointer = data[0];
+
+	return true;
+}
+
+
+/***
+* Function: read(uint8_t *data, uint8_t length)
+* Description: I2C read with register address auto-increment
+***/
+bool SimBMP280::read(uint8_t *data, uint8_t length)
+{
+	uint8_t i;
+
+	update();
+
+	for (i = 0; i < length; i++)
+	{
+		data[i] = _regs[_pointer++];
+	}
+
+	return true;
+}
+
+
+void SimBMP280::reset(void)
+{
+	uint8_t i;
+
+	memset(_regs, 0, sizeof(_regs));
+
+	for (i = 0; i < 12; i++)
+	{
+		_regs[SIM_BMP280_REG_CALIB_00 + 2 * i] = simBMP280Calibration[i] & 0xFF;
+		_regs[SIM_BMP280_REG_CALIB_00 + 2 * i + 1] = simBMP280Calibration[i] >> 8;
+	}
+
+	_regs[SIM_BMP280_REG_ID] = SIM_BMP280_CHIP_ID;
+	_regs[SIM_BMP280_REG_PRESS_MSB] = 0x80; // Reset values of the data registers
+	_regs[SIM_BMP280_REG_TEMP_MSB] = 0x80;
+
+	_pointer = 0;
+	_conversionEndUs = 0;
+	_normalNextUs = 0;
+}
+
+
+void SimBMP280::writeRegister(uint8_t reg, uint8_t value)
+{
+	switch (reg)
+	{
+		case SIM_BMP280_REG_RESET:
+			if (value == SIM_BMP280_RESET_VALUE)
+			{
+				reset();
+			}
+			break;
+
+		case SIM_BMP280_REG_CONFIG:
+			_regs[reg] = value & 0xFD; // Bit 1 is reserved
+			break;
+
+		case SIM_BMP280_REG_CTRL_MEAS:
+			_regs[reg] = value;
+			_conversionEndUs = 0;
+			switch (value & 0x03)
+			{
+				case 0x01:
+				case 0x02:
+					startConversion(); // Forced Mode
+					break;
+				case 0x03:
+					_normalNextUs = hostGetTimeUs(); // Normal Mode starts right away
+					update();
+					break;
+			}
+			break;
+
+		default:
+			break; // Read only
+	}
+}
+
+
+void SimBMP280::startConversion(void)
+{
+	_conversionEndUs = hostGetTimeUs() + conversionTimeUs();
+	_regs[SIM_BMP280_REG_STATUS] |= SIM_BMP280_STATUS_MEASURING;
+}
+
+
+void SimBMP280::update(void)
+{
+	unsigned long long now = hostGetTimeUs();
+	byte mode = _regs[SIM_BMP280_REG_CTRL_MEAS] & 0x03;
+
+	for (;;)
+	{
+		if ((_conversionEndUs != 0) && (now >= _conversionEndUs))
+		{
+			latchResults();
+			_regs[SIM_BMP280_REG_STATUS] &= ~SIM_BMP280_STATUS_MEASURING;
+
+			if (mode == 0x03)
+			{
+				_normalNextUs = _conversionEndUs + simBMP280StandbyUs[_regs[SIM_BMP280_REG_CONFIG] >> 5];
+			}
+			else
+			{
+				_regs[SIM_BMP280_REG_CTRL_MEAS] &= ~0x03; // Back to Sleep Mode
+			}
+			_conversionEndUs = 0;
+		}
+		else if ((mode == 0x03) && (_conversionEndUs == 0) && (now >= _normalNextUs))
+		{
+			_conversionEndUs = _normalNextUs + conversionTimeUs();
+			_regs[SIM_BMP280_REG_STATUS] |= SIM_BMP280_STATUS_MEASURING;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+
+void SimBMP280::latchResults(void)
+{
+	byte ctrl = _regs[SIM_BMP280_REG_CTRL_MEAS];
+	long temperature = quantize(_rawTemperature, ctrl >> 5);
+	long pressure = quantize(_rawPressure, (ctrl >> 2) & 0x07);
+
+	_regs[SIM_BMP280_REG_PRESS_MSB] = (pressure >> 12) & 0xFF;
+	_regs[SIM_BMP280_REG_PRESS_MSB + 1] = (pressure >> 4) & 0xFF;
+	_regs[SIM_BMP280_REG_PRESS_MSB + 2] = (pressure & 0x0F) << 4;
+	_regs[SIM_BMP280_REG_TEMP_MSB] = (temperature >> 12) & 0xFF;
+	_regs[SIM_BMP280_REG_TEMP_MSB + 1] = (temperature >> 4) & 0xFF;
+	_regs[SIM_BMP280_REG_TEMP_MSB + 2] = (temperature & 0x0F) << 4;
+
+	_measurementCount++;
+}
+
+
+/***
+* Function: conversionTimeUs(void)
+* Description: Typical measurement time (datasheet appendix 2)
+***/
+unsigned long SimBMP280::conversionTimeUs(void)
+{
+	byte ctrl = _regs[SIM_BMP280_REG_CTRL_MEAS];
+	byte osT = ctrl >> 5;
+	byte osP = (ctrl >> 2) & 0x07;
+	unsigned long time = 1000;
+
+	if (osT > 0)
+	{
+		time += 2000UL << (((osT > 5) ? 5 : osT) - 1);
+	}
+	if (osP > 0)
+	{
+		time += (2000UL << (((osP > 5) ? 5 : osP) - 1)) + 500;
+	}
+
+	return time + _conversionDelayUs;
+}
+
+
+/***
+* Function: quantize(long raw, uint8_t oversampling)
+* Description: Output resolution is 16 bits at x1 and one more bit for
+*              each oversampling step, up to 20 bits (datasheet 3.3.1)
+***/
+long SimBMP280::quantize(long raw, uint8_t oversampling)
+{
+	if (oversampling == 0)
+	{
+		return SIM_BMP280_RAW_SKIPPED;
+	}
+
+	if (oversampling > 5)
+	{
+		oversampling = 5;
+	}
+
+	return raw & ~((1L << (5 - oversampling)) - 1);
+}
@@ -0,0 +1,60 @@
+/*
+* File:    SimBMP280.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - BMP280 register model
+*
+* Register map, forced/normal mode timing, oversampling resolution and
+* the I2C write format (register/data pairs) of the BMP280 datasheet.
+* The ADC outputs are set directly as raw words; the defaults and the
+* calibration data are the datasheet example (section 8.2: 25.08 degC,
+* 100653 Pa).
+***/
+
+#ifndef SIM_BMP280_H
+#define SIM_BMP280_H
+
+#include "Wire.h"
+
+#define		SIM_BMP280_ADDRESS					0x76
+#define		SIM_BMP280_CHIP_ID					0x58
+#define		SIM_BMP280_RAW_TEMPERATURE			519888
+#define		SIM_BMP280_RAW_PRESSURE				415148
+#define		SIM_BMP280_RAW_SKIPPED				0x80000
+
+class SimBMP280 : public SimI2CDevice
+{
+	public:
+		SimBMP280(uint8_t address = SIM_BMP280_ADDRESS);
+
+		void	setRawTemperature(long raw) { _rawTemperature = raw; }
+		void	setRawPressure(long raw) { _rawPressure = raw; }
+		unsigned long getMeasurementCount(void) { return _measurementCount; }
+		void	setConversionDelayUs(unsigned long delayUs) { _conversionDelayUs = delayUs; } // Slow or stuck device
+
+		virtual bool write(const uint8_t *data, uint8_t length, bool stop);
+		virtual bool read(uint8_t *data, uint8_t length);
+
+	private:
+		uint8_t		_regs[256];
+		uint8_t		_pointer;
+		long		_rawTemperature, _rawPressure;
+		unsigned long long _conversionEndUs; // Virtual time when the running conversion ends
+		unsigned long long _normalNextUs; // Virtual time of the next Normal Mode conversion
+		unsigned long _measurementCount;
+		unsigned long _conversionDelayUs; // Added to every conversion
+
+		void		reset(void);
+		void		update(void); // Bring the model up to the current virtual time
+		void		writeRegister(uint8_t reg, uint8_t value);
+		void		startConversion(void);
+		void		latchResults(void);
+		unsigned long conversionTimeUs(void);
+		long		quantize(long raw, uint8_t oversampling);
+};
+
+#endif
@@ -0,0 +1,257 @@
+/*
+* File:    SimSi7020.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - Si7020 command model
+***/
+
+#include "SimSi7020.h"
+
+#define		SIM_SI7020_CMD_MEASURE_RH_HOLD			0xE5
+#define		SIM_SI7020_CMD_MEASURE_RH_NO_HOLD		0xF5
+#define		SIM_SI7020_CMD_MEASURE_TEMP_HOLD		0xE3
+#define		SIM_SI7020_CMD_MEASURE_TEMP_NO_HOLD		0xF3
+#define		SIM_SI7020_CMD_READ_TEMP_PREV_RH		0xE0
+#define		SIM_SI7020_CMD_RESET					0xFE
+#define		SIM_SI7020_CMD_WRITE_USER_REG			0xE6
+#define		SIM_SI7020_CMD_READ_USER_REG			0xE7
+#define		SIM_SI7020_CMD_WRITE_HEATER_REG			0x51
+#define		SIM_SI7020_CMD_READ_HEATER_REG			0x11
+#define		SIM_SI7020_CMD_READ_EID_1				0xFA
+#define		SIM_SI7020_CMD_READ_EID_2				0xFC
+#define		SIM_SI7020_CMD_READ_FW_REV				0x84
+
+#define		SIM_SI7020_USER_REG_DEFAULT				0x3A
+#define		SIM_SI7020_USER_REG_WRITE_MASK			0x85 // RES1, HTRE, RES0
+#define		SIM_SI7020_DEVICE_ID					0x14 // SNB_3 of the Si7020
+#define		SIM_SI7020_FW_REVISION					0x20
+
+// Maximum conversion times in us for each resolution setting (RES1:RES0)
+static const unsigned long simSi7020RhConversionUs[4] = { 12000, 3100, 4500, 7000 };
+static const unsigned long simSi7020TemperatureConversionUs[4] = { 10800, 3800, 6200, 2400 };
+
+
+SimSi7020::SimSi7020(uint8_t address) : SimI2CDevice(address)
+{
+	_rawRelHumidity = SIM_SI7020_RAW_RH;
+	_rawTemperature = SIM_SI7020_RAW_TEMPERATURE;
+	_measurementCount = 0;
+	reset();
+}
+
+
+void SimSi7020::reset(void)
+{
+	_userRegister = SIM_SI7020_USER_REG_DEFAULT;
+	_heaterRegister = 0;
+	_lastTemperature = 0;
+	_command = 0;
+	_hold = false;
+	_conversionEndUs = 0;
+	_responseLength = 0;
+}
+
+
+/***
+* Function: write(const uint8_t *data, uint8_t length, bool stop)
+* Description: I2C write: command followed by its parameters
+***/
+bool SimSi7020::write(const uint8_t *data, uint8_t length, bool stop)
+{
+	(void) stop;
+
+	if (length == 0)
+	{
+		return true; // Address only
+	}
+
+	_command = data[0];
+	_responseLength = 0;
+
+	switch (_command)
+	{
+		case SIM_SI7020_CMD_MEASURE_RH_HOLD:
+		case SIM_SI7020_CMD_MEASURE_TEMP_HOLD:
+			startConversion(_command, true);
+			break;
+
+		case SIM_SI7020_CMD_MEASURE_RH_NO_HOLD:
+		case SIM_SI7020_CMD_MEASURE_TEMP_NO_HOLD:
+			startConversion(_command, false);
+			break;
+
+		case SIM_SI7020_CMD_READ_TEMP_PREV_RH:
+			_response[0] = _lastTemperature >> 8;
+			_response[1] = _lastTemperature & 0xFF;
+			_responseLength = 2; // No checksum for this command
+			break;
+
+		case SIM_SI7020_CMD_RESET:
+			reset();
+			break;
+
+		case SIM_SI7020_CMD_WRITE_USER_REG:
+			if (length > 1)
+			{
+				_userRegister = (_userRegister & ~SIM_SI7020_USER_REG_WRITE_MASK) | (data[1] & SIM_SI7020_USER_REG_WRITE_MASK);
+			}
+			break;
+
+		case SIM_SI7020_CMD_READ_USER_REG:
+			_response[0] = _userRegister;
+			_responseLength = 1;
+			break;
+
+		case SIM_SI7020_CMD_WRITE_HEATER_REG:
+			if (length > 1)
+			{
+				_heaterRegister = data[1] & 0x0F;
+			}
+			break;
+
+		case SIM_SI7020_CMD_READ_HEATER_REG:
+			_response[0] = _heaterRegister;
+			_responseLength = 1;
+			break;
+
+		case SIM_SI7020_CMD_READ_EID_1:
+			memset(_response, 0, 8); // SNA_3..SNA_0 with their checksums
+			_responseLength = 8;
+			break;
+
+		case SIM_SI7020_CMD_READ_EID_2:
+			memset(_response, 0, 6);
+			_response[0] = SIM_SI7020_DEVICE_ID;
+			_response[2] = crc8(_response, 2);
+			_response[5] = crc8(_response, 5);
+			_responseLength = 6;
+			break;
+
+		case SIM_SI7020_CMD_READ_FW_REV:
+			_response[0] = SIM_SI7020_FW_REVISION;
+			_responseLength = 1;
+			break;
+
+		default:
+			return false; // Unknown command
+	}
+
+	return true;
+}
+
+
+/***
+* Function: readStretchUs(void)
+* Description: Hold Master measurements keep SCL low until the conversion ends
+***/
+unsigned long SimSi7020::readStretchUs(void)
+{
+	unsigned long long now = hostGetTimeUs();
+
+	if ((_conversionEndUs != 0) && _hold && (now < _conversionEndUs))
+	{
+		return (unsigned long) (_conversionEndUs - now);
+	}
+
+	return 0;
+}
+
+
+/***
+* Function: read(uint8_t *data, uint8_t length)
+* Description: No Hold Master measurements NACK the read until the
+*              conversion ends
+***/
+bool SimSi7020::read(uint8_t *data, uint8_t length)
+{
+	uint8_t i;
+
+	if (_conversionEndUs != 0)
+	{
+		if (hostGetTimeUs() < _conversionEndUs)
+		{
+			return false; // Conversion in progress
+		}
+
+		_conversionEndUs = 0;
+		_measurementCount++;
+
+		if ((_command == SIM_SI7020_CMD_MEASURE_RH_HOLD) || (_command == SIM_SI7020_CMD_MEASURE_RH_NO_HOLD))
+		{
+			_lastTemperature = _rawTemperature; // Temperature is measured with every RH conversion
+			setWordResponse(_rawRelHumidity);
+		}
+		else
+		{
+			setWordResponse(_rawTemperature);
+		}
+	}
+
+	for (i = 0; i < length; i++)
+	{
+		data[i] = (i < _responseLength) ? _response[i] : 0xFF;
+	}
+
+	return true;
+}
+
+
+void SimSi7020::startConversion(uint8_t command, bool hold)
+{
+	unsigned long time = temperatureConversionUs();
+
+	if ((command == SIM_SI7020_CMD_MEASURE_RH_HOLD) || (command == SIM_SI7020_CMD_MEASURE_RH_NO_HOLD))
+	{
+		time += rhConversionUs();
+	}
+
+	_hold = hold;
+	_conversionEndUs = hostGetTimeUs() + time;
+}
+
+
+void SimSi7020::setWordResponse(unsigned short value)
+{
+	_response[0] = value >> 8;
+	_response[1] = value & 0xFF;
+	_response[2] = crc8(_response, 2);
+	_responseLength = 3;
+}
+
+
+unsigned long SimSi7020::rhConversionUs(void)
+{
+	return simSi7020RhConversionUs[((_userRegister >> 6) & 0x02) | (_userRegister & 0x01)];
+}
+
+
+unsigned long SimSi7020::temperatureConversionUs(void)
+{
+	return simSi7020TemperatureConversionUs[((_userRegister >> 6) & 0x02) | (_userRegister & 0x01)];
+}
+
+
+/***
+* Function: crc8(const uint8_t *data, uint8_t length)
+* Description: Checksum x^8 + x^5 + x^4 + 1, initialized with 0x00
+***/
+uint8_t SimSi7020::crc8(const uint8_t *data, uint8_t length)
+{
+	uint8_t crc = 0;
+	uint8_t i, bit;
+
+	for (i = 0; i < length; i++)
+	{
+		crc ^= data[i];
+		for (bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x31) : (uint8_t) (crc << 1);
+		}
+	}
+
+	return crc;
+}
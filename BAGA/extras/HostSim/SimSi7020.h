@@ -0,0 +1,60 @@
+/*
+* File:    SimSi7020.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - Si7020 command model
+*
+* Hold Master (clock stretching) and No Hold Master (NACK until the
+* conversion is done) measurements, temperature from the previous RH
+* measurement, user and heater registers, and the checksum byte. The
+* conversion times follow the resolution in the user register
+* (datasheet table 2, maximum values). The outputs are set directly as
+* raw words.
+***/
+
+#ifndef SIM_SI7020_H
+#define SIM_SI7020_H
+
+#include "Wire.h"
+
+#define		SIM_SI7020_ADDRESS					0x40
+#define		SIM_SI7020_RAW_RH					29362 // 50 %RH (status bits 0b10)
+#define		SIM_SI7020_RAW_TEMPERATURE			26868 // 25 degC
+
+class SimSi7020 : public SimI2CDevice
+{
+	public:
+		SimSi7020(uint8_t address = SIM_SI7020_ADDRESS);
+
+		void	setRawRelHumidity(unsigned short raw) { _rawRelHumidity = raw; }
+		void	setRawTemperature(unsigned short raw) { _rawTemperature = raw; }
+		unsigned long getMeasurementCount(void) { return _measurementCount; }
+
+		virtual bool write(const uint8_t *data, uint8_t length, bool stop);
+		virtual unsigned long readStretchUs(void);
+		virtual bool read(uint8_t *data, uint8_t length);
+
+	private:
+		uint8_t		_userRegister, _heaterRegister;
+		unsigned short _rawRelHumidity, _rawTemperature;
+		unsigned short _lastTemperature; // Temperature measured with the last RH conversion
+		uint8_t		_command; // Last command received
+		bool		_hold; // Last measurement command is Hold Master
+		unsigned long long _conversionEndUs;
+		uint8_t		_response[8];
+		uint8_t		_responseLength;
+		unsigned long _measurementCount;
+
+		void		reset(void);
+		void		startConversion(uint8_t command, bool hold);
+		void		setWordResponse(unsigned short value);
+		unsigned long rhConversionUs(void);
+		unsigned long temperatureConversionUs(void);
+		static uint8_t crc8(const uint8_t *data, uint8_t length);
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+* File:    Wire.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - Wire library stand-in
+*
+* Routes transactions to simulated devices (SimI2CDevice) attached with
+* Wire.attachDevice(). The virtual clock advances by the time each
+* transaction takes on the bus (9 bit times per byte plus start/stop,
+* clock stretching included). Every transaction and byte is counted.
+***/
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+#define		WIRE_HAS_TIMEOUT						// Same API as the AVR core 1.8.3+
+#define		BUFFER_LENGTH							32
+#define		HOST_WIRE_MAX_DEVICES					8
+#define		HOST_WIRE_DEFAULT_CLOCK_HZ				100000
+
+
+/* Simulated I2C device */
+class SimI2CDevice
+{
+	public:
+		SimI2CDevice(uint8_t address) : _address(address) {}
+		virtual ~SimI2CDevice() {}
+
+		uint8_t			getAddress(void) { return _address; }
+
+		// Called with the bytes of a write transaction. Returns false to NACK them.
+		virtual bool	write(const uint8_t *data, uint8_t length, bool stop) = 0;
+		// Time the device holds SCL low before answering a read (clock stretching)
+		virtual unsigned long readStretchUs(void) { return 0; }
+		// Called for a read transaction. Returns false to NACK the address.
+		virtual bool	read(uint8_t *data, uint8_t length) = 0;
+
+	private:
+		uint8_t			_address;
+};
+
+
+/* Bus statistics */
+typedef struct
+{
+	unsigned long	transactions; // Writes and reads (each START or repeated START)
+	unsigned long	bytesWritten; // Data bytes sent to devices (address bytes not included)
+	unsigned long	bytesRead; // Data bytes received from devices
+	unsigned long	nacks; // Transactions not acknowledged
+	unsigned long	timeouts; // Transactions aborted by the Wire timeout
+	unsigned long long busTimeUs; // Time spent on the bus
+} HostWireStats;
+
+
+class TwoWire
+{
+	public:
+		TwoWire();
+
+		void	begin(void);
+		void	end(void) {}
+		void	setClock(uint32_t clock);
+		void	setWireTimeout(uint32_t timeout = 25000, bool resetWithTimeout = false);
+		bool	getWireTimeoutFlag(void) { return _timeoutFlag; }
+		void	clearWireTimeoutFlag(void) { _timeoutFlag = false; }
+
+		void	beginTransmission(uint8_t address);
+		void	beginTransmission(int address) { beginTransmission((uint8_t) address); }
+		size_t	write(uint8_t value);
+		size_t	write(const uint8_t *data, size_t length);
+		uint8_t	endTransmission(bool sendStop = true);
+		uint8_t	endTransmission(uint8_t sendStop) { return endTransmission(sendStop != 0); }
+
+		uint8_t	requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop);
+		uint8_t	requestFrom(uint8_t address, uint8_t quantity) { return requestFrom(address, quantity, (uint8_t) 1); }
+		uint8_t	requestFrom(int address, int quantity) { return requestFrom((uint8_t) address, (uint8_t) quantity, (uint8_t) 1); }
+		uint8_t	requestFrom(int address, int quantity, int sendStop) { return requestFrom((uint8_t) address, (uint8_t) quantity, (uint8_t) sendStop); }
+		int		available(void);
+		int		read(void);
+		int		peek(void);
+
+		/* Host only */
+		void	attachDevice(SimI2CDevice *device);
+		void	getStats(HostWireStats *stats);
+		void	resetStats(void);
+
+	private:
+		SimI2CDevice	*_devices[HOST_WIRE_MAX_DEVICES];
+		uint8_t			_deviceCount;
+		uint32_t		_clockHz;
+		uint32_t		_timeoutUs;
+		bool			_timeoutFlag;
+
+		uint8_t			_txAddress;
+		uint8_t			_txBuffer[BUFFER_LENGTH];
+		uint8_t			_txLength;
+		uint8_t			_rxBuffer[BUFFER_LENGTH];
+		uint8_t			_rxLength, _rxIndex;
+
+		HostWireStats	_stats;
+
+		SimI2CDevice	*findDevice(uint8_t address);
+		void			busTime(unsigned int bytes, bool stop); // Advance the clock by the duration of a transaction
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,17 @@
+/*
+* File:    wdt.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BAGA A3
+* Host Simulation - avr/wdt.h stand-in
+***/
+
+#ifndef HOST_AVR_WDT_H
+#define HOST_AVR_WDT_H
+
+void	wdt_disable(void); // Stop the watchdog (the armed interrupt is cancelled)
+
+#endif
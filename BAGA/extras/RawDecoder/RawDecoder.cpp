@@ -0,0 +1,177 @@
+/*
+* File:    RawDecoder.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/************************************************************************
+* BAGA A3
+* Raw Log Decoder (host tool)
+*
+* Converts a log file written by the DataLoggerRaw example to physical
+* units. The compensation runs on the host computer using the
+* double precision formulas from the BMP280 datasheet (section 8.1) and
+* the Si7020 conversion used by the Si7020 library.
+*
+* Build: g++ -O2 -o RawDecoder RawDecoder.cpp
+* Usage: RawDecoder < RAW.CSV > LOG.CSV
+*
+* Input lines:
+*   #CAL,T1,T2,T3,P1,P2,P3,P4,P5,P6,P7,P8,P9
+*   Timestamp,Press_Raw,Temp_Press_Raw,Hum_Rel_Raw,Temp_Raw,Rad_Sol_Adc,Vol_Bat_Adc
+*   <data lines>
+* A new #CAL line (e.g. from a concatenated file) replaces the
+* calibration data used for the following lines.
+*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define		MAX_LINE_LENGTH					256
+#define		CALIBRATION_WORDS				12
+#define		ADC_FULL_SCALE					4092 // BAGA_ADC_FULL_SCALE: 12-bit oversampled readings (1023 << 2)
+
+/* BMP280 factory calibration data */
+typedef struct
+{
+	unsigned short 	T1;
+	signed short 	T2, T3;
+	unsigned short 	P1;
+	signed short 	P2, P3, P4, P5, P6, P7, P8, P9;
+} Calibration;
+
+/* Header of the decoded file */
+const char strDataString[] = "Timestamp,Temp_C,Hum_Rel,Press_Abs_Pa,Temp_Press_C,Rad_Sol,Vol_Bat";
+
+
+/***
+* Function: parseCalibration(const char *line, Calibration *calib)
+* Description: Parse a "#CAL,..." header line
+* Params: line - Line read from the log file
+*         calib - Structure to save the calibration data in
+* Returns: 0 if the line was parsed successfully, 1 if not
+***/
+int parseCalibration(const char *line, Calibration *calib)
+{
+	long words[CALIBRATION_WORDS];
+	const char *str = strchr(line, ',');
+	int i;
+
+	for (i = 0; i < CALIBRATION_WORDS; i++)
+	{
+		if (str == NULL)
+		{
+			return 1;
+		}
+		words[i] = strtol(str + 1, NULL, 10);
+		str = strchr(str + 1, ',');
+	}
+
+	calib->T1 = (unsigned short) words[0];
+	calib->T2 = (signed short) words[1];
+	calib->T3 = (signed short) words[2];
+	calib->P1 = (unsigned short) words[3];
+	calib->P2 = (signed short) words[4];
+	calib->P3 = (signed short) words[5];
+	calib->P4 = (signed short) words[6];
+	calib->P5 = (signed short) words[7];
+	calib->P6 = (signed short) words[8];
+	calib->P7 = (signed short) words[9];
+	calib->P8 = (signed short) words[10];
+	calib->P9 = (signed short) words[11];
+
+	return 0;
+}
+
+
+/***
+* Function: compensateBMP280(const Calibration *calib, long rawT, long rawP, double *temperature, double *pressure)
+* Description: BMP280 floating point compensation (datasheet section 8.1)
+* Params: calib - Calibration data
+*         rawT, rawP - Uncompensated temperature and pressure words
+*         temperature - Compensated temperature in Celsius degrees
+*         pressure - Compensated pressure in Pa
+* Returns: none
+***/
+void compensateBMP280(const Calibration *calib, long rawT, long rawP, double *temperature, double *pressure)
+{
+	double var1, var2, tFine, p;
+
+	var1 = (((double) rawT) / 16384.0 - ((double) calib->T1) / 1024.0) * ((double) calib->T2);
+	var2 = ((((double) rawT) / 131072.0 - ((double) calib->T1) / 8192.0) * (((double) rawT) / 131072.0 - ((double) calib->T1) / 8192.0)) * ((double) calib->T3);
+	tFine = var1 + var2;
+	*temperature = tFine / 5120.0;
+
+	var1 = (tFine / 2.0) - 64000.0;
+	var2 = var1 * var1 * ((double) calib->P6) / 32768.0;
+	var2 = var2 + var1 * ((double) calib->P5) * 2.0;
+	var2 = (var2 / 4.0) + (((double) calib->P4) * 65536.0);
+	var1 = (((double) calib->P3) * var1 * var1 / 524288.0 + ((double) calib->P2) * var1) / 524288.0;
+	var1 = (1.0 + var1 / 32768.0) * ((double) calib->P1);
+	if (var1 == 0.0)
+	{
+		*pressure = 0; // Avoid exception caused by division by zero
+		return;
+	}
+	p = 1048576.0 - (double) rawP;
+	p = (p - (var2 / 4096.0)) * 6250.0 / var1;
+	var1 = ((double) calib->P9) * p * p / 2147483648.0;
+	var2 = p * ((double) calib->P8) / 32768.0;
+	*pressure = p + (var1 + var2 + ((double) calib->P7)) / 16.0;
+}
+
+
+int main(void)
+{
+	char line[MAX_LINE_LENGTH];
+	Calibration calib;
+	int hasCalibration = 0;
+	unsigned long lineNumber = 0;
+
+	printf("%s\n", strDataString);
+
+	while (fgets(line, sizeof(line), stdin) != NULL)
+	{
+		unsigned long timestamp;
+		long rawP, rawT;
+		unsigned long rawRH, rawTemperature, solarAdc, batteryAdc;
+		double temperatureBMP, pressure;
+
+		lineNumber++;
+
+		if (strncmp(line, "#CAL", 4) == 0)
+		{
+			hasCalibration = (parseCalibration(line, &calib) == 0);
+			if (!hasCalibration)
+			{
+				fprintf(stderr, "line %lu: invalid calibration header\n", lineNumber);
+			}
+			continue;
+		}
+
+		if (sscanf(line, "%lu,%ld,%ld,%lu,%lu,%lu,%lu", &timestamp, &rawP, &rawT, &rawRH, &rawTemperature, &solarAdc, &batteryAdc) != 7)
+		{
+			continue; // Column header or empty line
+		}
+
+		if (!hasCalibration)
+		{
+			fprintf(stderr, "line %lu: data before calibration header\n", lineNumber);
+			continue;
+		}
+
+		compensateBMP280(&calib, rawT, rawP, &temperatureBMP, &pressure);
+
+		printf("%lu,%.2f,%.2f,%.2f,%.2f,%lu,%lu\n",
+			timestamp,
+			(175.25 * rawTemperature / 65536) - 46.85, // Same conversion as Si7020::readTemperaturePostHumidity()
+			(125.0 * rawRH / 65536) - 6, // Same conversion as Si7020::readRelHumidity()
+			pressure,
+			temperatureBMP,
+			(solarAdc * 45000 / ADC_FULL_SCALE) / 25, // Same conversion as BAGA::readSolarRadiation()
+			batteryAdc * 4500 / ADC_FULL_SCALE); // Same conversion as BAGA::readBatteryVoltage()
+	}
+
+	return 0;
+}
@@ -7,6 +7,29 @@
 /* Include Files */
 #include "BMP280.h"
 
+// Standard atmosphere altitude in cm for p / p0 = 0.5 to 1.125 in 1/64 steps:
+// h = 44330.77 * (1 - (p / p0) ^ 0.190263)
+const signed long BMP280AltitudeTable[BMP280_ALTITUDE_TABLE_SIZE] PROGMEM =
+{
+	547725, 524910, 502649, 480912, 459672, 438904, 418587, 398697,
+	379217, 360126, 341410, 323050, 305033, 287345, 269972, 252903,
+	236124, 219627, 203400, 187434, 171719, 156247, 141010, 126000,
+	111208, 96630, 82257, 68083, 54102, 40309, 26698, 13263,
+	0, -13096, -26030, -38807, -51430, -63903, -76231, -88418,
+	-100466
+};
+
+// Measurement profiles, ordered by increasing current consumption.
+// RMS noise values are typical figures for a single forced measurement.
+const BMP280Profile BMP280Profiles[BMP280_PROFILE_COUNT] PROGMEM =
+{
+	{ BMP280_PRESS_OVERSAMPLING_1,	BMP280_TEMP_OVERSAMPLING_1,	5500,	6400,	2740,	330 }, // Ultra low power
+	{ BMP280_PRESS_OVERSAMPLING_2,	BMP280_TEMP_OVERSAMPLING_1,	7500,	8700,	4170,	240 }, // Low power
+	{ BMP280_PRESS_OVERSAMPLING_4,	BMP280_TEMP_OVERSAMPLING_1,	11500,	13300,	7020,	160 }, // Standard resolution
+	{ BMP280_PRESS_OVERSAMPLING_8,	BMP280_TEMP_OVERSAMPLING_1,	19500,	22500,	12700,	120 }, // High resolution
+	{ BMP280_PRESS_OVERSAMPLING_16,	BMP280_TEMP_OVERSAMPLING_2,	37500,	43200,	24800,	80 } // Ultra high resolution
+};
+
 BMP280::BMP280() // Constructor
 {
 	_isEnabled = false;
@@ -14,6 +37,9 @@ BMP280::BMP280() // Constructor
 	_mode = BMP280_MODE_SLEEP; // POR mode value 
 	_pressureOversampling = BMP280_PRESS_OVERSAMPLING_1; // POR pressure oversampling value 
 	_temperatureOversampling = BMP280_TEMP_OVERSAMPLING_1; // POR temperature oversampling value 
+	_standbyTime = BMP280_STANDBY_0_5_MS; // POR standby time value
+	_filter = BMP280_FILTER_OFF; // POR IIR filter value
+	_profile = BMP280_PROFILE_ULTRA_LOW_POWER; // POR oversampling values match the ultra low power profile
 	_rawTemperature = 0;
 	_rawPressure = 0;
 	_tFine = 0;
@@ -28,13 +54,14 @@ BMP280::BMP280() // Constructor
 ***/
 byte BMP280::begin(void)
 {
+	I2C_BUS_TRACE_CALL("BMP280::begin");
+	
 	byte result = 0;
 	
-	Wire.begin(); // Configure I2C
+	BMP280Bus::begin(); // Configure I2C
 		
 	setMode(BMP280_MODE_FORCED); // Disable pressure oversampling
-	setPressureOversampling(BMP280_PRESS_OVERSAMPLING_1); // Disable pressure oversampling
-	setTempOversampling(BMP280_TEMP_OVERSAMPLING_1); // Disable temperature oversampling
+	setProfile(BMP280_PROFILE_ULTRA_LOW_POWER); // Disable pressure and temperature oversampling
 	
 	result |= loadCalibrationData(); // Load factory calibration values
 	
@@ -67,9 +94,11 @@ bool BMP280::isEnabled(void)
 ***/
 byte BMP280:: reset()
 {
+	I2C_BUS_TRACE_CALL("BMP280::reset");
+	
 	byte result = 0;
 	
-	result = writeByte(BMP280_REG_RESET, BMP280_RESET);
+	result = BMP280Bus::writeByte(BMP280_REG_RESET, BMP280_RESET);
 	
 	if (result == 0)
 	{
@@ -87,13 +116,12 @@ byte BMP280:: reset()
 ***/
 byte BMP280::makeSingleMeasurement(void)
 {
+	I2C_BUS_TRACE_CALL("BMP280::makeSingleMeasurement");
+	
 	byte result = 1;
-	byte settings = _mode | (_pressureOversampling << 2) | (_temperatureOversampling << 5);
-	signed long var1, var2;
 	unsigned long time;
-	unsigned char rawData[6];
 	
-	result = writeByte(BMP280_REG_CTRL_MEASURE, settings);
+	result = startMeasurement();
 	
 	time = millis(); // Timestamp
 	
@@ -102,33 +130,16 @@ byte BMP280::makeSingleMeasurement(void)
 		result = 1;
 		do
 		{
-			if (getMode() != BMP280_MODE_SLEEP) // Check measurement done bit
+			if (isReady() == true) // Check if the device went back to sleep mode
 			{
 				result = 0;
 				break;
 			}
 		} while((millis() - time) < BMP280_MEASUREMENTS_TIMEOUT_MS); // Wait for the timeout to expire
 			
-		//if (isMeasurementDone() == true)
 		if (result == 0)
 		{
-			result = readByteArray(BMP280_REG_PRESS_MSB, rawData, 6); // Read raw data
-					
-			if (result == 0)
-			{
-				_dataUpdated = true;
-				_rawPressure = (((unsigned long) rawData[0]) << 12) + (((unsigned long) rawData[1]) << 4) + (((unsigned long) rawData[2]) >> 4);
-				_rawTemperature = (((unsigned long) rawData[3]) << 12) + (((unsigned long) rawData[4]) << 4) + (((unsigned long) rawData[5]) >> 4);
-				
-					
-				var1 = ((((_rawTemperature >> 3) - ((signed long) _calibT1 << 1))) * ((signed long) _calibT2)) >> 11;
-				var2 = (((((_rawTemperature >> 4) - ((signed long) _calibT1)) * ((_rawTemperature >> 4) - ((signed long) _calibT1))) >> 12) * ((signed long) _calibT3)) >> 14;
-				_tFine = var1 + var2;
-			}
-			else
-			{
-				//Serial1.println("[ERROR]");
-			}
+			result = fetch(); // Read raw data
 		}
 		else
 		{
@@ -140,6 +151,106 @@ byte BMP280::makeSingleMeasurement(void)
 }
 
 
+/***
+* Function: startMeasurement(void)
+* Description: Trigger a single measurement without waiting for it to complete.
+*              Use getMeasurementTimeUs() to know how long the conversion takes,
+*              isReady() to check if it is completed and fetch() to read it.
+* Params: none
+* Returns: 0 if the measurement was triggered, 1 if not
+***/
+byte BMP280::startMeasurement(void)
+{
+	I2C_BUS_TRACE_CALL("BMP280::startMeasurement");
+	
+	byte settings = _mode | (_pressureOversampling << 2) | (_temperatureOversampling << 5);
+	
+	if (_mode == BMP280_MODE_NORMAL)
+	{
+		return 0; // Device is already measuring continuously
+	}
+	
+	return BMP280Bus::writeByte(BMP280_REG_CTRL_MEASURE, settings);
+}
+
+
+/***
+* Function: isReady(void)
+* Description: Check if the triggered measurement is completed
+*              (in Forced Mode the device returns to Sleep Mode when done,
+*              in Normal Mode the data registers always hold the last result)
+* Params: none
+* Returns: true if the measurement is completed, false if not (or if the
+*          mode could not be read)
+***/
+bool BMP280::isReady(void)
+{
+	I2C_BUS_TRACE_CALL("BMP280::isReady");
+	
+	if (_mode == BMP280_MODE_NORMAL)
+	{
+		return true; // No need to wait for a conversion
+	}
+	
+	return (getMode() == BMP280_MODE_SLEEP);
+}
+
+
+/***
+* Function: fetch(void)
+* Description: Read the results of the last completed measurement
+* Params: none
+* Returns: 0 if data was read successfully, 1 if not
+***/
+byte BMP280::fetch(void)
+{
+	I2C_BUS_TRACE_CALL("BMP280::fetch");
+	
+	byte result = 1;
+	unsigned char rawData[6];
+	
+	result = BMP280Bus::readRegisters(BMP280_REG_PRESS_MSB, rawData, 6); // Read raw data
+			
+	if (result == 0)
+	{
+		_dataUpdated = true;
+		_rawPressure = (((unsigned long) rawData[0]) << 12) + (((unsigned long) rawData[1]) << 4) + (((unsigned long) rawData[2]) >> 4);
+		_rawTemperature = (((unsigned long) rawData[3]) << 12) + (((unsigned long) rawData[4]) << 4) + (((unsigned long) rawData[5]) >> 4);
+		
+		_tFine = BMP280_compensateTFine(&_calib, _rawTemperature);
+	}
+	else
+	{
+		//Serial1.println("[ERROR]");
+	}
+
+	return result;
+}
+
+
+/***
+* Function: getMeasurementTimeUs(void)
+* Description: Get the maximum measurement time for the current oversampling
+*              settings (t_measure,max from the datasheet)
+* Params: none
+* Returns: Measurement time in microseconds
+***/
+unsigned long BMP280::getMeasurementTimeUs(void)
+{
+	unsigned long measurementTime = BMP280_MEAS_TIME_BASE_US;
+	
+	measurementTime += (unsigned long) BMP280_MEAS_TIME_PER_OVERSAMPLE_US * getOversamplingFactor(_temperatureOversampling);
+	
+	if (_pressureOversampling != BMP280_PRESS_OVERSAMPLING_OFF)
+	{
+		measurementTime += (unsigned long) BMP280_MEAS_TIME_PER_OVERSAMPLE_US * getOversamplingFactor(_pressureOversampling);
+		measurementTime += BMP280_MEAS_TIME_PRESS_OFFSET_US;
+	}
+	
+	return measurementTime;
+}
+
+
 /***
 * Function: readTemperature(void)
 * Description: Read temperature from last measurement
@@ -148,16 +259,24 @@ byte BMP280::makeSingleMeasurement(void)
 ***/
 float BMP280::readTemperature(void)
 {
-	signed long temperatureVal;
-
-    temperatureVal = (_tFine * 5 + 128) >> 8;
-
-	_temperature = ((float)temperatureVal)/100;
+	_temperature = ((float)readTemperatureCentiC())/100;
 	
 	return _temperature;
 }
 
 
+/***
+* Function: readTemperatureCentiC(void)
+* Description: Read temperature from last measurement without floating point math
+* Params: none
+* Returns: Temperature value in centi-degrees Celsius (2512 = 25.12 degC)
+***/
+signed long BMP280::readTemperatureCentiC(void)
+{
+	return BMP280_compensateTemperature(_tFine);
+}
+
+
 /***
 * Function: readPressure(void)
 * Description: Read pressure from last measurement
@@ -166,9 +285,22 @@ float BMP280::readTemperature(void)
 ***/
 signed long BMP280::readPressure(void)
 {
-	signed long pressureVal;
-	signed long var1, var2;
+	_pressure = readPressureFixed<BMP280_PRECISION_32BIT>();
 	
+	return _pressure; // Return pressure value in Pa
+}
+
+
+/***
+* Function: readPressureFixed<BMP280_PRECISION_32BIT>(void)
+* Description: Read pressure from last measurement using the 32-bit
+*              integer compensation formula from the datasheet
+* Params: none
+* Returns: Pressure value in Pascal
+***/
+template <>
+signed long BMP280::readPressureFixed<BMP280_PRECISION_32BIT>(void)
+{
 	if (_pressureOversampling == BMP280_PRESS_OVERSAMPLING_OFF)
 	{
 #ifdef DEBUG
@@ -177,34 +309,85 @@ signed long BMP280::readPressure(void)
 		return 0;
 	}
 
-	var1 = (((signed long) _tFine) >> 1) - (signed long) 64000;
-	var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((signed long) _calibP6);
-	var2 = var2 + ((var1 * ((signed long) _calibP5)) << 1);
-	var2 = (var2 >> 2)+(((signed long) _calibP4) << 16);
-	var1 = (((_calibP3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((((signed long) _calibP2) * var1) >> 1)) >> 18;
-	var1 = ((((32768 + var1))*((signed long) _calibP1)) >> 15);
-	if (var1 == 0)
-	{
-		return 0; // Avoid exception caused by division by zero
-	}
-	pressureVal = (((unsigned long) (((signed long) 1048576) - _rawPressure)-(var2 >> 12)))*3125;
-	if (pressureVal < 0x80000000)
+	return (signed long) BMP280_compensatePressure(&_calib, _tFine, _rawPressure);
+}
+
+
+/***
+* Function: readPressureFixed<BMP280_PRECISION_64BIT>(void)
+* Description: Read pressure from last measurement using the 64-bit
+*              integer compensation formula from the datasheet
+* Params: none
+* Returns: Pressure value in Q24.8 Pascal (24674867 = 24674867/256 = 96386.2 Pa)
+***/
+template <>
+signed long BMP280::readPressureFixed<BMP280_PRECISION_64BIT>(void)
+{
+	signed long long pressureVal;
+	signed long long var1, var2;
+	
+	if (_pressureOversampling == BMP280_PRESS_OVERSAMPLING_OFF)
 	{
-		pressureVal = (pressureVal << 1) / ((unsigned long) var1);
+		return 0;
 	}
-	else
+
+	var1 = ((signed long long) _tFine) - 128000;
+	var2 = var1 * var1 * (signed long long) _calib.P6;
+	var2 = var2 + ((var1 * (signed long long) _calib.P5) << 17);
+	var2 = var2 + (((signed long long) _calib.P4) << 35);
+	var1 = ((var1 * var1 * (signed long long) _calib.P3) >> 8) + ((var1 * (signed long long) _calib.P2) << 12);
+	var1 = (((((signed long long) 1) << 47) + var1)) * ((signed long long) _calib.P1) >> 33;
+	if (var1 == 0)
 	{
-		pressureVal = (pressureVal / (unsigned long) var1) * 2;
+		return 0; // Avoid exception caused by division by zero
 	}
-	var1 = (((signed long) _calibP9) * ((signed long) (((pressureVal >> 3) * (pressureVal >> 3)) >> 13))) >> 12;
-	var2 = (((signed long) (pressureVal >> 2)) * ((signed long) _calibP8)) >> 13;
-	pressureVal = (unsigned long) ((signed long) pressureVal + ((var1 + var2 + _calibP7) >> 4));
+	pressureVal = 1048576 - _rawPressure;
+	pressureVal = (((pressureVal << 31) - var2) * 3125) / var1;
+	var1 = (((signed long long) _calib.P9) * (pressureVal >> 13) * (pressureVal >> 13)) >> 25;
+	var2 = (((signed long long) _calib.P8) * pressureVal) >> 19;
+	pressureVal = ((pressureVal + var1 + var2) >> 8) + (((signed long long) _calib.P7) << 4);
 
-	_pressure = pressureVal;
-	
-	return _pressure; // Return pressure value in Pa
+	return (signed long) pressureVal;
+}
+
+/***
+* Function: getRawTemperature(void)
+* Description: Get the uncompensated temperature word from last measurement
+*              (to be compensated later, e.g. on a host computer)
+* Params: none
+* Returns: Raw 20-bit temperature value
+***/
+signed long BMP280::getRawTemperature(void)
+{
+	return _rawTemperature;
+}
+
+
+/***
+* Function: getRawPressure(void)
+* Description: Get the uncompensated pressure word from last measurement
+*              (to be compensated later, e.g. on a host computer)
+* Params: none
+* Returns: Raw 20-bit pressure value
+***/
+signed long BMP280::getRawPressure(void)
+{
+	return _rawPressure;
+}
+
+
+/***
+* Function: getCalibrationData(BMP280CalibrationData *calib)
+* Description: Get a copy of the factory calibration data loaded by begin()
+* Params: calib - Structure to save the calibration data in
+* Returns: none
+***/
+void BMP280::getCalibrationData(BMP280CalibrationData *calib)
+{
+	*calib = _calib;
 }
 
+
 /***
 * Function: calcAltitude(void)
 * Description: Calculate altitude for a given pressure and temperature
@@ -221,6 +404,51 @@ float BMP280::calcAltitude(float absPressureMBar, float seaLevelPressureMBar, fl
 }
 
 
+/***
+* Function: calcAltitudeFast(signed long absPressurePa, signed long seaLevelPressurePa)
+* Description: Calculate altitude for a given pressure using the standard
+*              atmosphere and a lookup table instead of pow(). The result is
+*              within 1.2 m of the exact formula for 0.5 <= p / p0 <= 1.125
+*              (about -1000 m to 5500 m) and is clamped outside that range.
+* Params: absPressurePa - Absolute pressure in Pa
+*         seaLevelPressurePa - Sea level pressure in Pa
+* Returns: Altitude value in centimeters
+***/
+signed long BMP280::calcAltitudeFast(signed long absPressurePa, signed long seaLevelPressurePa)
+{
+	unsigned long ratio;
+	unsigned int index, fraction;
+	signed long altitudeLow, altitudeHigh;
+	
+	if ((absPressurePa <= 0) || (seaLevelPressurePa <= 0))
+	{
+		return 0; // Invalid pressure
+	}
+	
+	if (absPressurePa > BMP280_ALTITUDE_MAX_PRESSURE_PA)
+	{
+		absPressurePa = BMP280_ALTITUDE_MAX_PRESSURE_PA;
+	}
+	
+	ratio = (((unsigned long) absPressurePa) << 15) / ((unsigned long) seaLevelPressurePa); // Pressure ratio in Q15
+	ratio = constrain(ratio, BMP280_ALTITUDE_TABLE_START, BMP280_ALTITUDE_TABLE_START + (unsigned long) (BMP280_ALTITUDE_TABLE_SIZE - 1) * BMP280_ALTITUDE_TABLE_STEP);
+	
+	index = (ratio - BMP280_ALTITUDE_TABLE_START) / BMP280_ALTITUDE_TABLE_STEP;
+	fraction = (ratio - BMP280_ALTITUDE_TABLE_START) % BMP280_ALTITUDE_TABLE_STEP;
+	
+	if (index >= (BMP280_ALTITUDE_TABLE_SIZE - 1)) // Last table entry
+	{
+		index = BMP280_ALTITUDE_TABLE_SIZE - 2;
+		fraction = BMP280_ALTITUDE_TABLE_STEP;
+	}
+	
+	altitudeLow = (signed long) pgm_read_dword(&BMP280AltitudeTable[index]);
+	altitudeHigh = (signed long) pgm_read_dword(&BMP280AltitudeTable[index + 1]);
+	
+	return altitudeLow + ((altitudeHigh - altitudeLow) * (signed long) fraction) / BMP280_ALTITUDE_TABLE_STEP; // Linear interpolation
+}
+
+
 /***
 * Function: isMeasurementDone(void)
 * Description: Check if the measurement is completed (not valid for Forced Mode)
@@ -229,10 +457,12 @@ float BMP280::calcAltitude(float absPressureMBar, float seaLevelPressureMBar, fl
 ***/
 bool BMP280::isMeasurementDone(void)
 {
+	I2C_BUS_TRACE_CALL("BMP280::isMeasurementDone");
+	
 	byte result = 0;
 	byte status;
 
-	result = readByte(BMP280_REG_STATUS, &status); // Read status register
+	result = BMP280Bus::readByte(BMP280_REG_STATUS, &status); // Read status register
 	
 	if (result == 0)
 	{
@@ -256,10 +486,12 @@ bool BMP280::isMeasurementDone(void)
 ***/
 bool BMP280::isNVMDataReady(void)
 {
+	I2C_BUS_TRACE_CALL("BMP280::isNVMDataReady");
+	
 	byte result = 0;
 	byte status;
 
-	result = readByte(BMP280_REG_STATUS, &status); // Read status register
+	result = BMP280Bus::readByte(BMP280_REG_STATUS, &status); // Read status register
 	
 	if (result == 0)
 	{
@@ -280,21 +512,29 @@ bool BMP280::isNVMDataReady(void)
 ***/
 byte BMP280::loadCalibrationData(void)
 {
+	I2C_BUS_TRACE_CALL("BMP280::loadCalibrationData");
+	
 	byte result = 0;
+	unsigned char rawData[BMP280_CALIB_DATA_LENGTH];
 	
-	result |= readUInt(BMP280_REG_CALIB_00, &_calibT1);
-	result |= readInt(BMP280_REG_CALIB_02, &_calibT2);
-	result |= readInt(BMP280_REG_CALIB_04, &_calibT3);
-
-	result |= readUInt(BMP280_REG_CALIB_06, &_calibP1);
-	result |= readInt(BMP280_REG_CALIB_08, &_calibP2);
-	result |= readInt(BMP280_REG_CALIB_10, &_calibP3);
-	result |= readInt(BMP280_REG_CALIB_12, &_calibP4);
-	result |= readInt(BMP280_REG_CALIB_14, &_calibP5);
-	result |= readInt(BMP280_REG_CALIB_16, &_calibP6);
-	result |= readInt(BMP280_REG_CALIB_18, &_calibP7);
-	result |= readInt(BMP280_REG_CALIB_20, &_calibP8);
-	result |= readInt(BMP280_REG_CALIB_22, &_calibP9);
+	result = BMP280Bus::readRegisters(BMP280_REG_CALIB_00, rawData, BMP280_CALIB_DATA_LENGTH); // Read the whole calibration block at once
+	
+	if (result == 0)
+	{
+		_calib.T1 = (unsigned short) BMP280Bus::toUInt(&rawData[0]);
+		_calib.T2 = (signed short) BMP280Bus::toUInt(&rawData[2]);
+		_calib.T3 = (signed short) BMP280Bus::toUInt(&rawData[4]);
+
+		_calib.P1 = (unsigned short) BMP280Bus::toUInt(&rawData[6]);
+		_calib.P2 = (signed short) BMP280Bus::toUInt(&rawData[8]);
+		_calib.P3 = (signed short) BMP280Bus::toUInt(&rawData[10]);
+		_calib.P4 = (signed short) BMP280Bus::toUInt(&rawData[12]);
+		_calib.P5 = (signed short) BMP280Bus::toUInt(&rawData[14]);
+		_calib.P6 = (signed short) BMP280Bus::toUInt(&rawData[16]);
+		_calib.P7 = (signed short) BMP280Bus::toUInt(&rawData[18]);
+		_calib.P8 = (signed short) BMP280Bus::toUInt(&rawData[20]);
+		_calib.P9 = (signed short) BMP280Bus::toUInt(&rawData[22]);
+	}
 
 	return result;
 }
@@ -304,13 +544,18 @@ byte BMP280::loadCalibrationData(void)
 * Function: getMode(void)
 * Description: Get current device mode value
 * Params: none
-* Returns: Device mode value
+* Returns: Device mode value, BMP280_MODE_UNKNOWN if the register could not be read
 ***/
 byte BMP280::getMode(void)
 {
+	I2C_BUS_TRACE_CALL("BMP280::getMode");
+	
 	byte currentModeValue = 0;
 	
-	readByte(BMP280_REG_CTRL_MEASURE, &currentModeValue); // Read value from register
+	if (BMP280Bus::readByte(BMP280_REG_CTRL_MEASURE, &currentModeValue) != 0) // Read value from register
+	{
+		return BMP280_MODE_UNKNOWN; // Bus error: not the same as Sleep Mode
+	}
 
 	return currentModeValue & BMP280_MODE_BYTE_MASK;
 }
@@ -336,7 +581,7 @@ void BMP280::setMode(byte mode)
 void BMP280::setTempOversampling(byte tempOversampling)
 {
 	_temperatureOversampling = tempOversampling;
-
+	_profile = BMP280_PROFILE_CUSTOM;
 }
 
 /***
@@ -348,159 +593,287 @@ void BMP280::setTempOversampling(byte tempOversampling)
 void BMP280::setPressureOversampling(byte pressureOversampling)
 {
 	_pressureOversampling = pressureOversampling;
+	_profile = BMP280_PROFILE_CUSTOM;
 }
 
+/***
+* Function: getTempOversampling(void)
+* Description: Get device temperature oversampling setting
+* Params: none
+* Returns: Temperature oversampling setting
+***/
+byte BMP280::getTempOversampling(void)
+{
+	return _temperatureOversampling;
+}
+
+/***
+* Function: getPressureOversampling(void)
+* Description: Get device pressure oversampling setting
+* Params: none
+* Returns: Pressure oversampling setting
+***/
+byte BMP280::getPressureOversampling(void)
+{
+	return _pressureOversampling;
+}
 
-// I2C R/W functions
 
 /***
-* Function: readInt(byte address, signed short *value)
-* Description: Read 16-bit signed integer from device
-* Params: address - Register address
-*         value - Variable to save the value in
-* Returns: 0 if the value was read successfully, 1 if not
+* Function: setProfile(byte profile)
+* Description: Set pressure and temperature oversampling from a named
+*              measurement profile (BMP280_PROFILE_xxx)
+* Params: New measurement profile
+* Returns: none
 ***/
-byte BMP280::readInt(byte address, signed short *value)
+void BMP280::setProfile(byte profile)
 {
-	byte result;
-	byte byteCount = 0;
-	byte data[2] = { 0, 0};
+	BMP280Profile info;
 	
-	Wire.beginTransmission(BMP280_I2C_ADDRESS);
-	Wire.write(address);
-	result = Wire.endTransmission();
-	
-	if(readByteArray(address,data,2) == 0)
+	if (getProfileInfo(profile, &info) == 0)
 	{
-		*value = ((unsigned short) data[1]) << 8;
-		*value |= data[0];
+		_pressureOversampling = info.pressureOversampling;
+		_temperatureOversampling = info.temperatureOversampling;
+		_profile = profile;
 	}
-		
-	return result;
 }
 
 
 /***
-* Function: readUInt(byte address, unsigned short *value)
-* Description: Read 16-bit unsigned integer from device
-* Params: address - Register address
-*         value - Variable to save the value in
-* Returns: 0 if the value was read successfully, 1 if not
+* Function: getProfile(void)
+* Description: Get the current measurement profile
+* Params: none
+* Returns: Profile value (BMP280_PROFILE_CUSTOM if the oversampling
+*          was set directly)
 ***/
-byte BMP280::readUInt(unsigned char address, unsigned short *value)
+byte BMP280::getProfile(void)
 {
-	byte result;
-	byte byteCount = 0;
-	byte data[2] = { 0, 0};
-	
-	Wire.beginTransmission(BMP280_I2C_ADDRESS);
-	Wire.write(address);
-	result = Wire.endTransmission();
-	
-	if(readByteArray(address,data,2) == 0)
+	return _profile;
+}
+
+
+/***
+* Function: getProfileInfo(byte profile, BMP280Profile *info)
+* Description: Get the settings, measurement time, current consumption
+*              and noise of a measurement profile
+* Params: profile - Measurement profile (BMP280_PROFILE_xxx)
+*         info - Structure to save the profile data in
+* Returns: 0 if the profile exists, 1 if not
+***/
+byte BMP280::getProfileInfo(byte profile, BMP280Profile *info)
+{
+	if (profile >= BMP280_PROFILE_COUNT)
 	{
-		*value = ((unsigned short) data[1]) << 8;
-		*value |= data[0];
+		return 1; // Unknown profile
 	}
-		
-	return result;
+	
+	memcpy_P(info, &BMP280Profiles[profile], sizeof(BMP280Profile));
+	
+	return 0;
 }
 
 
 /***
-* Function: readByte(unsigned char address, unsigned char *value)
-* Description: Read byte from device
-* Params: address - Register address
-*         value - Variable to save the value in
-* Returns: 0 if the value was read successfully, 1 if not
+* Function: findProfileForNoise(unsigned int maxNoiseCentiPa)
+* Description: Find the lowest power profile whose RMS noise meets a target
+* Params: maxNoiseCentiPa - Maximum RMS pressure noise in 0.01 Pa
+* Returns: Profile value (BMP280_PROFILE_ULTRA_HIGH_RES if no profile
+*          meets the target)
 ***/
-byte BMP280::readByte(unsigned char address, unsigned char *value)
+byte BMP280::findProfileForNoise(unsigned int maxNoiseCentiPa)
 {
-	byte result;
-	
-	Wire.beginTransmission(BMP280_I2C_ADDRESS);
-	Wire.write(address);
-	result = Wire.endTransmission();
+	byte profile;
+	BMP280Profile info;
 	
-	if (result == 0)
+	for (profile = 0; profile < BMP280_PROFILE_COUNT; profile++)
 	{
-		Wire.requestFrom(BMP280_I2C_ADDRESS,1);
-		while(!Wire.available()) ; // wait until bytes are ready
-		while(Wire.available()) // Wait until bytes are ready to read
+		getProfileInfo(profile, &info);
+		
+		if (info.noiseCentiPa <= maxNoiseCentiPa)
 		{
-			*value = Wire.read(); // Read byte
+			return profile;
 		}
 	}
-		
-	return result;
+	
+	return BMP280_PROFILE_ULTRA_HIGH_RES; // Lowest noise available
+}
+
+
+/***
+* Function: getTransactionCount(void)
+* Description: Get number of I2C transactions since the last reset
+* Params: none
+* Returns: Number of I2C transactions (each write and each read counts as one)
+***/
+unsigned long BMP280::getTransactionCount(void)
+{
+	return BMP280Bus::getTransactionCount();
+}
+
+
+/***
+* Function: resetTransactionCount(void)
+* Description: Reset I2C transactions counter
+* Params: none
+* Returns: none
+***/
+void BMP280::resetTransactionCount(void)
+{
+	BMP280Bus::resetTransactionCount();
+}
+
+
+/***
+* Function: getNackCount(void)
+* Description: Get number of I2C operations not acknowledged by the device
+* Params: none
+* Returns: Number of NACKs since the last reset
+***/
+unsigned int BMP280::getNackCount(void)
+{
+	return BMP280Bus::getNackCount();
+}
+
+
+/***
+* Function: getTimeoutCount(void)
+* Description: Get number of I2C operations that timed out
+* Params: none
+* Returns: Number of timeouts since the last reset
+***/
+unsigned int BMP280::getTimeoutCount(void)
+{
+	return BMP280Bus::getTimeoutCount();
 }
 
+
 /***
-* Function: readByteArray(unsigned char address, unsigned char * array, unsigned char length)
-* Description: Read byte array from device
-* Params: address - Register address
-*         array - Variable to save the values in
-*         length - Number of bytes to read
-* Returns: 0 if the values were read successfully, 1 if not
+* Function: getRetryCount(void)
+* Description: Get number of retried I2C transactions
+* Params: none
+* Returns: Number of retries since the last reset
 ***/
-byte BMP280::readByteArray(unsigned char address, unsigned char * array, unsigned char length)
+unsigned int BMP280::getRetryCount(void)
 {
-	byte result;
-	byte byteCount = 0;
-	Wire.beginTransmission(BMP280_I2C_ADDRESS);
-	Wire.write(address);
-	result = Wire.endTransmission();
+	return BMP280Bus::getRetryCount();
+}
+
+
+/***
+* Function: resetErrorCounters(void)
+* Description: Reset I2C error counters
+* Params: none
+* Returns: none
+***/
+void BMP280::resetErrorCounters(void)
+{
+	BMP280Bus::resetErrorCounters();
+}
+
+
+/***
+* Function: setStandbyTime(byte standbyTime)
+* Description: Set Normal Mode standby time between measurements
+*              (applied on the next startNormalMode() call)
+* Params: New standby time setting (BMP280_STANDBY_xxx)
+* Returns: none
+***/
+void BMP280::setStandbyTime(byte standbyTime)
+{
+	_standbyTime = standbyTime;
+}
+
+
+/***
+* Function: setFilter(byte filter)
+* Description: Set IIR filter coefficient
+*              (applied on the next startNormalMode() call)
+* Params: New IIR filter setting (BMP280_FILTER_xxx)
+* Returns: none
+***/
+void BMP280::setFilter(byte filter)
+{
+	_filter = filter;
+}
+
+
+/***
+* Function: startNormalMode(void)
+* Description: Start continuous measurements (Normal Mode) using the current
+*              oversampling, standby time and IIR filter settings.
+*              Afterwards each fetch() call reads the last filtered result
+*              with a single burst read and no conversion wait.
+* Params: none
+* Returns: 0 if the device entered Normal Mode, 1 if not
+***/
+byte BMP280::startNormalMode(void)
+{
+	I2C_BUS_TRACE_CALL("BMP280::startNormalMode");
+	
+	byte result = 0;
+	byte oversampling = (_pressureOversampling << BMP280_PRESS_OVERSAMPLING_BYTE) | (_temperatureOversampling << BMP280_TEMP_OVERSAMPLING_BYTE);
+	byte config = (_standbyTime << BMP280_STANDBY_BYTE) | (_filter << BMP280_FILTER_BYTE);
+	
+	result |= BMP280Bus::writeByte(BMP280_REG_CTRL_MEASURE, oversampling | BMP280_MODE_SLEEP); // Writes to config register may be ignored outside Sleep Mode
+	result |= BMP280Bus::writeByte(BMP280_REG_CONFIG, config & (BMP280_STANDBY_BYTE_MASK | BMP280_FILTER_BYTE_MASK));
 	
 	if (result == 0)
 	{
-		Wire.requestFrom(BMP280_I2C_ADDRESS,(int)length);
-		while(Wire.available() != length) ; // wait until bytes are ready
-		while(Wire.available()) // Wait until bytes are ready to read
+		result = BMP280Bus::writeByte(BMP280_REG_CTRL_MEASURE, oversampling | BMP280_MODE_NORMAL);
+		
+		if (result == 0)
 		{
-			array[byteCount++] = Wire.read(); // Read byte
+			_mode = BMP280_MODE_NORMAL;
 		}
 	}
-		
+	
 	return result;
 }
 
 
 /***
-* Function: writeByte(unsigned char address, unsigned char value)
-* Description: Write byte to device
-* Params: address - Register address
-*         value - Value to write
-* Returns: 0 if the value was written successfully, 1 if not
+* Function: stopNormalMode(void)
+* Description: Stop continuous measurements and go back to Sleep Mode
+*              (later measurements use Forced Mode)
+* Params: none
+* Returns: 0 if the device entered Sleep Mode, 1 if not
 ***/
-byte BMP280::writeByte(unsigned char address, unsigned char value)
+byte BMP280::stopNormalMode(void)
 {
-	byte result;
+	I2C_BUS_TRACE_CALL("BMP280::stopNormalMode");
+	
+	byte result = 0;
+	byte oversampling = (_pressureOversampling << BMP280_PRESS_OVERSAMPLING_BYTE) | (_temperatureOversampling << BMP280_TEMP_OVERSAMPLING_BYTE);
+	
+	result = BMP280Bus::writeByte(BMP280_REG_CTRL_MEASURE, oversampling | BMP280_MODE_SLEEP);
+	
+	if (result == 0)
+	{
+		_mode = BMP280_MODE_FORCED;
+	}
 	
-	Wire.beginTransmission(BMP280_I2C_ADDRESS);
-	Wire.write(address);
-	Wire.write(value);
-	result = Wire.endTransmission();
-
 	return result;
 }
 
 
 /***
-* Function: writeByteArray(unsigned char address, unsigned char * array, unsigned char length)
-* Description: Write byte array to device
-* Params: address - Register address
-*         value - Value to write
-* Returns: 0 if the value was written successfully, 1 if not
+* Function: getOversamplingFactor(byte oversampling)
+* Description: Convert an oversampling setting to the number of samples
+* Params: oversampling - Oversampling setting (BMP280_xxx_OVERSAMPLING_x)
+* Returns: Number of samples taken for each measurement (0 if skipped)
 ***/
-byte BMP280::writeByteArray(unsigned char address, unsigned char * array, unsigned char length)
+byte BMP280::getOversamplingFactor(byte oversampling)
 {
-	byte result;
+	if (oversampling == 0)
+	{
+		return 0; // Measurement skipped
+	}
 	
-	Wire.beginTransmission(BMP280_I2C_ADDRESS);
-	Wire.write(address);
-	Wire.write(array, length);
-	result = Wire.endTransmission();
-
-	return result;
+	if (oversampling > BMP280_PRESS_OVERSAMPLING_16)
+	{
+		oversampling = BMP280_PRESS_OVERSAMPLING_16; // All other settings are x16
+	}
+	
+	return 1 << (oversampling - 1);
 }
 
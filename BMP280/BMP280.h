@@ -23,6 +23,8 @@
 #endif
 
 #include <Wire.h>
+#include <I2CBus.h>
+#include "BMP280Compensation.h"
 
 
 #define 	BMP280_SEA_LEVEL_PRESSURE_PA				101325
@@ -32,6 +34,19 @@
 
 #define		BMP280_MEASUREMENTS_TIMEOUT_MS			50
 
+// I2C transactions
+#define		BMP280_I2C_TIMEOUT_US					2000 // Maximum duration of each bus operation
+
+// Worst case durations
+#define		BMP280_I2C_TRANSACTION_MAX_US			I2C_BUS_TRANSACTION_MAX_US(BMP280_I2C_TIMEOUT_US)
+#define		BMP280_SINGLE_MEASUREMENT_MAX_MS		(BMP280_MEASUREMENTS_TIMEOUT_MS + ((3 * BMP280_I2C_TRANSACTION_MAX_US) / 1000) + 1)
+
+// Maximum measurement time (datasheet, appendix 2: t_measure,max)
+#define		BMP280_MEAS_TIME_BASE_US				1250 // Base conversion time
+#define		BMP280_MEAS_TIME_PER_OVERSAMPLE_US		2300 // Time per temperature or pressure oversample
+#define		BMP280_MEAS_TIME_PRESS_OFFSET_US		575	 // Extra time when pressure measurement is enabled
+#define		BMP280_MEAS_TIME_MAX_US					(BMP280_MEAS_TIME_BASE_US + (2 * 16 * BMP280_MEAS_TIME_PER_OVERSAMPLE_US) + BMP280_MEAS_TIME_PRESS_OFFSET_US) // x16 temperature and pressure oversampling
+
 // Registers
 #define 	BMP280_REG_CALIB_00						0x88
 #define 	BMP280_REG_CALIB_01						0x89
@@ -71,6 +86,18 @@
 #define 	BMP280_REG_TEMP_LSB						0xFB
 #define 	BMP280_REG_TEMP_XLSB					0xFC
 
+// Integer compensation precision (readPressureFixed)
+#define		BMP280_PRECISION_32BIT					0 // 32-bit datasheet path, result in Pa
+#define		BMP280_PRECISION_64BIT					1 // 64-bit datasheet path, result in Q24.8 Pa (Pa * 256)
+
+// Fast altitude lookup table (calcAltitudeFast)
+#define		BMP280_ALTITUDE_TABLE_SIZE				41
+#define		BMP280_ALTITUDE_TABLE_START				16384 // First pressure ratio (p / p0 = 0.5 in Q15)
+#define		BMP280_ALTITUDE_TABLE_STEP				512 // Pressure ratio step (1/64 in Q15)
+#define		BMP280_ALTITUDE_MAX_PRESSURE_PA			131071 // Keeps (p << 15) within 32 bits
+
+#define		BMP280_CALIB_DATA_LENGTH				24 // Calibration block size (BMP280_REG_CALIB_00 to BMP280_REG_CALIB_23)
+
 
 // BMP280_REG_RESET
 #define 	BMP280_RESET							0xB6 
@@ -87,6 +114,7 @@
 #define		BMP280_MODE_SLEEP						0x00
 #define		BMP280_MODE_FORCED						0x01
 #define		BMP280_MODE_NORMAL						0x03
+#define		BMP280_MODE_UNKNOWN						0xFF // getMode() could not read the register
 
 #define		BMP280_PRESS_OVERSAMPLING_BYTE			2
 #define		BMP280_PRESS_OVERSAMPLING_BYTE_MASK		0x1C
@@ -106,6 +134,50 @@
 #define		BMP280_TEMP_OVERSAMPLING_8				0x04 // Temperature resolution 19 bit / 0.0006 °C
 #define		BMP280_TEMP_OVERSAMPLING_16				0x05 // Temperature resolution 20 bit / 0.0003 °C
 
+// Measurement profiles (datasheet table 4)
+#define		BMP280_PROFILE_ULTRA_LOW_POWER			0 // Pressure x1, temperature x1
+#define		BMP280_PROFILE_LOW_POWER				1 // Pressure x2, temperature x1
+#define		BMP280_PROFILE_STANDARD					2 // Pressure x4, temperature x1
+#define		BMP280_PROFILE_HIGH_RES					3 // Pressure x8, temperature x1
+#define		BMP280_PROFILE_ULTRA_HIGH_RES			4 // Pressure x16, temperature x2
+#define		BMP280_PROFILE_COUNT					5
+#define		BMP280_PROFILE_CUSTOM					0xFF // Oversampling set with setTempOversampling/setPressureOversampling
+
+// BMP280_REG_CONFIG
+
+#define		BMP280_FILTER_BYTE						2
+#define		BMP280_FILTER_BYTE_MASK					0x1C
+#define		BMP280_FILTER_OFF						0x00 // IIR filter off
+#define		BMP280_FILTER_2							0x01 // IIR filter coefficient 2
+#define		BMP280_FILTER_4							0x02 // IIR filter coefficient 4
+#define		BMP280_FILTER_8							0x03 // IIR filter coefficient 8
+#define		BMP280_FILTER_16						0x04 // IIR filter coefficient 16
+
+#define		BMP280_STANDBY_BYTE						5
+#define		BMP280_STANDBY_BYTE_MASK				0xE0
+#define		BMP280_STANDBY_0_5_MS					0x00 // Normal Mode standby time 0.5 ms
+#define		BMP280_STANDBY_62_5_MS					0x01 // Normal Mode standby time 62.5 ms
+#define		BMP280_STANDBY_125_MS					0x02 // Normal Mode standby time 125 ms
+#define		BMP280_STANDBY_250_MS					0x03 // Normal Mode standby time 250 ms
+#define		BMP280_STANDBY_500_MS					0x04 // Normal Mode standby time 500 ms
+#define		BMP280_STANDBY_1000_MS					0x05 // Normal Mode standby time 1000 ms
+#define		BMP280_STANDBY_2000_MS					0x06 // Normal Mode standby time 2000 ms
+#define		BMP280_STANDBY_4000_MS					0x07 // Normal Mode standby time 4000 ms
+
+
+// Measurement profile settings and performance
+typedef struct
+{
+	byte			pressureOversampling; // BMP280_PRESS_OVERSAMPLING_x
+	byte			temperatureOversampling; // BMP280_TEMP_OVERSAMPLING_x
+	unsigned int	measurementTimeTypUs; // Typical measurement time in us (datasheet table 13)
+	unsigned int	measurementTimeMaxUs; // Maximum measurement time in us (datasheet table 13)
+	unsigned int	currentNa; // Typical current at 1 Hz forced mode in nA (datasheet table 14)
+	unsigned int	noiseCentiPa; // Typical RMS pressure noise without IIR filter in 0.01 Pa
+} BMP280Profile;
+
+/* Register access (16-bit registers are LSB first) */
+typedef I2CBus<BMP280_I2C_ADDRESS, I2C_BUS_LSB_FIRST, BMP280_I2C_TIMEOUT_US> BMP280Bus;
 
 
 class BMP280
@@ -117,9 +189,20 @@ class BMP280
 		bool 			isEnabled(void); // Check if the device is initialized
 		byte 			reset(); // Reset device to its POR state
 		byte 			makeSingleMeasurement(void); // Trigger the device to make a single measurement of temperature and pressure
+		byte 			startMeasurement(void); // Trigger a single measurement without waiting for it to complete
+		bool 			isReady(void); // Check if the triggered measurement is completed
+		byte 			fetch(void); // Read the results of the last completed measurement
+		unsigned long	getMeasurementTimeUs(void); // Get the maximum measurement time for the current oversampling settings
 		float 			readTemperature(void); // Read temperature from last measurement
+		signed long		readTemperatureCentiC(void); // Read temperature from last measurement in centi-degrees Celsius (no floating point)
 		signed long		readPressure(void); // Read pressure from last measurement
+		template <byte precision>
+		signed long		readPressureFixed(void); // Read pressure from last measurement with the selected integer precision (no floating point)
+		signed long		getRawTemperature(void); // Get the uncompensated 20-bit temperature word from last measurement
+		signed long		getRawPressure(void); // Get the uncompensated 20-bit pressure word from last measurement
+		void			getCalibrationData(BMP280CalibrationData *calib); // Get a copy of the factory calibration data
 		float 			calcAltitude(float absPressureMBar, float seaLevelPressureMBar, float temperatureC); // Calculate altitude for a given pressure and temperature
+		signed long		calcAltitudeFast(signed long absPressurePa, signed long seaLevelPressurePa); // Calculate altitude in cm (standard atmosphere) without floating point
 		bool 			isMeasurementDone(void); // Check if the measurement is completed (not valid for Forced Mode)
 		bool 			isNVMDataReady(void); // Check if the NVM data was copied to image registers
 		byte 			loadCalibrationData(void); // Load factory calibration data
@@ -127,30 +210,43 @@ class BMP280
 		void 			setMode(byte mode); //  Set device mode
 		void			setTempOversampling(byte tempOversampling); // Set device temperature oversampling setting
 		void 			setPressureOversampling(byte pressureOversampling); // Set device pressure oversampling setting
+		byte			getTempOversampling(void); // Get device temperature oversampling setting
+		byte			getPressureOversampling(void); // Get device pressure oversampling setting
+		void 			setProfile(byte profile); // Set oversampling from a named measurement profile
+		byte 			getProfile(void); // Get the current measurement profile
+		byte 			getProfileInfo(byte profile, BMP280Profile *info); // Get the settings and performance of a measurement profile
+		byte 			findProfileForNoise(unsigned int maxNoiseCentiPa); // Find the lowest power profile that meets a noise target
+		void 			setStandbyTime(byte standbyTime); // Set Normal Mode standby time between measurements
+		void 			setFilter(byte filter); // Set IIR filter coefficient
+		byte 			startNormalMode(void); // Start continuous measurements (Normal Mode)
+		byte 			stopNormalMode(void); // Stop continuous measurements and go back to Sleep Mode
+		unsigned long	getTransactionCount(void); // Get number of I2C transactions since the last reset
+		void			resetTransactionCount(void); // Reset I2C transactions counter
+		unsigned int	getNackCount(void); // Get number of I2C operations not acknowledged by the device
+		unsigned int	getTimeoutCount(void); // Get number of I2C operations that timed out
+		unsigned int	getRetryCount(void); // Get number of retried I2C transactions
+		void			resetErrorCounters(void); // Reset I2C error counters
 		
 	private:
 		bool 			_isEnabled;
 		bool 			_dataUpdated;
 		byte 			_mode, _pressureOversampling, _temperatureOversampling;
+		byte 			_standbyTime, _filter;
+		byte 			_profile;
 		
 		signed long 	_rawTemperature, _rawPressure, _tFine;
 		float			_temperature;
 		signed long		_pressure;
 		
-		unsigned short 	_calibT1, _calibP1; // Calibration data
-		signed short 		_calibT2, _calibT3, _calibP2, _calibP3, _calibP4, _calibP5, _calibP6, _calibP7, _calibP8, _calibP9; // Calibration data
+		BMP280CalibrationData _calib; // Calibration data
 		byte			_oversampling;
 		
-		
-
-		byte 			readInt(unsigned char address, signed short *value); // Read 16-bit signed integer from device
-		byte 			readUInt(unsigned char address, unsigned short *value); // Read 16-bit unsigned integer from device
-		byte 			readByte(unsigned char address, unsigned char *value); // Read byte from device
-		byte 			readByteArray(unsigned char address, unsigned char * array, unsigned char length); // Read byte array from device
-		byte 			writeByte(unsigned char address, unsigned char value); // Write byte to device
-		byte 			writeByteArray(unsigned char address, unsigned char * array, unsigned char length); // Write byte array to device
+		byte 			getOversamplingFactor(byte oversampling); // Convert an oversampling setting to the number of samples
 };
 
+// Only the instantiated precision variant is linked
+template <> signed long BMP280::readPressureFixed<BMP280_PRECISION_32BIT>(void);
+template <> signed long BMP280::readPressureFixed<BMP280_PRECISION_64BIT>(void);
 
 
 
@@ -0,0 +1,103 @@
+/*
+* File:    BMP280Compensation.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/* Include Files */
+#include "BMP280Compensation.h"
+
+
+/***
+* Function: BMP280_compensateTFine(const BMP280CalibrationData *calib, int32_t rawTemperature)
+* Description: Calculate the fine temperature value used by the pressure compensation
+* Params: calib - Calibration data
+*         rawTemperature - Raw 20-bit temperature value
+* Returns: t_fine value
+***/
+int32_t BMP280_compensateTFine(const BMP280CalibrationData *calib, int32_t rawTemperature)
+{
+	int32_t var1, var2;
+	
+	var1 = ((((rawTemperature >> 3) - ((int32_t) calib->T1 << 1))) * ((int32_t) calib->T2)) >> 11;
+	var2 = (((((rawTemperature >> 4) - ((int32_t) calib->T1)) * ((rawTemperature >> 4) - ((int32_t) calib->T1))) >> 12) * ((int32_t) calib->T3)) >> 14;
+	
+	return var1 + var2;
+}
+
+
+/***
+* Function: BMP280_compensateTemperature(int32_t tFine)
+* Description: Convert the fine temperature value to centi-degrees Celsius
+* Params: tFine - t_fine value
+* Returns: Temperature value in centi-degrees Celsius (2512 = 25.12 degC)
+***/
+int32_t BMP280_compensateTemperature(int32_t tFine)
+{
+	return (tFine * 5 + 128) >> 8;
+}
+
+
+/***
+* Function: BMP280_compensatePressure(const BMP280CalibrationData *calib, int32_t tFine, int32_t rawPressure)
+* Description: Calculate pressure using the 32-bit integer formula from the datasheet
+* Params: calib - Calibration data
+*         tFine - t_fine value from the same measurement
+*         rawPressure - Raw 20-bit pressure value
+* Returns: Pressure value in Pascal (0 if the calibration data is invalid)
+***/
+uint32_t BMP280_compensatePressure(const BMP280CalibrationData *calib, int32_t tFine, int32_t rawPressure)
+{
+	uint32_t pressureVal;
+	int32_t var1, var2;
+
+	var1 = (tFine >> 1) - (int32_t) 64000;
+	var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t) calib->P6);
+	var2 = var2 + ((var1 * ((int32_t) calib->P5)) << 1);
+	var2 = (var2 >> 2) + (((int32_t) calib->P4) << 16);
+	var1 = (((((int32_t) calib->P3) * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((((int32_t) calib->P2) * var1) >> 1)) >> 18;
+	var1 = ((((32768 + var1)) * ((int32_t) calib->P1)) >> 15);
+	if (var1 == 0)
+	{
+		return 0; // Avoid exception caused by division by zero
+	}
+	pressureVal = (((uint32_t) (((int32_t) 1048576) - rawPressure)) - (uint32_t) (var2 >> 12)) * 3125;
+	if (pressureVal < 0x80000000)
+	{
+		pressureVal = (pressureVal << 1) / ((uint32_t) var1);
+	}
+	else
+	{
+		pressureVal = (pressureVal / (uint32_t) var1) * 2;
+	}
+	var1 = (((int32_t) calib->P9) * ((int32_t) (((((int32_t) pressureVal) >> 3) * (((int32_t) pressureVal) >> 3)) >> 13))) >> 12;
+	var2 = ((((int32_t) pressureVal) >> 2) * ((int32_t) calib->P8)) >> 13;
+	pressureVal = (uint32_t) ((int32_t) pressureVal + ((var1 + var2 + calib->P7) >> 4));
+
+	return pressureVal;
+}
+
+
+/***
+* Function: BMP280_compensateBatch(const BMP280CalibrationData *calib, const int32_t *rawTemperature, const int32_t *rawPressure, int32_t *temperature, uint32_t *pressure, unsigned int count)
+* Description: Compensate an array of raw samples (scalar reference implementation)
+* Params: calib - Calibration data
+*         rawTemperature - Array of raw temperature values
+*         rawPressure - Array of raw pressure values
+*         temperature - Array to save the temperatures in (centi-degrees Celsius)
+*         pressure - Array to save the pressures in (Pa)
+*         count - Number of samples
+* Returns: none
+***/
+void BMP280_compensateBatch(const BMP280CalibrationData *calib, const int32_t *rawTemperature, const int32_t *rawPressure, int32_t *temperature, uint32_t *pressure, unsigned int count)
+{
+	unsigned int i;
+	int32_t tFine;
+	
+	for (i = 0; i < count; i++)
+	{
+		tFine = BMP280_compensateTFine(calib, rawTemperature[i]);
+		temperature[i] = BMP280_compensateTemperature(tFine);
+		pressure[i] = BMP280_compensatePressure(calib, tFine, rawPressure[i]);
+	}
+}
@@ -0,0 +1,45 @@
+/*
+* File:    BMP280Compensation.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BMP280 A1
+*
+* BMP280 integer compensation functions (datasheet 32-bit formulas)
+*
+* This file has no Arduino dependencies so the same code can be used
+* on the board and to compensate archived raw samples on a host computer.
+***/
+
+#ifndef BMP280_COMPENSATION_H
+#define BMP280_COMPENSATION_H
+
+/* Include Files */
+#include <stdint.h>
+
+// Factory calibration data (BMP280_REG_CALIB_00 to BMP280_REG_CALIB_23)
+typedef struct __attribute__((packed))
+{
+	unsigned short 	T1;
+	signed short 	T2;
+	signed short 	T3;
+	unsigned short 	P1;
+	signed short 	P2;
+	signed short 	P3;
+	signed short 	P4;
+	signed short 	P5;
+	signed short 	P6;
+	signed short 	P7;
+	signed short 	P8;
+	signed short 	P9;
+} BMP280CalibrationData;
+
+
+int32_t 	BMP280_compensateTFine(const BMP280CalibrationData *calib, int32_t rawTemperature); // Calculate t_fine from the raw temperature
+int32_t 	BMP280_compensateTemperature(int32_t tFine); // Convert t_fine to centi-degrees Celsius
+uint32_t 	BMP280_compensatePressure(const BMP280CalibrationData *calib, int32_t tFine, int32_t rawPressure); // Calculate pressure in Pa
+void 		BMP280_compensateBatch(const BMP280CalibrationData *calib, const int32_t *rawTemperature, const int32_t *rawPressure, int32_t *temperature, uint32_t *pressure, unsigned int count); // Compensate an array of raw samples
+
+#endif
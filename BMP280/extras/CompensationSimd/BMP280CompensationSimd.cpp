@@ -0,0 +1,235 @@
+/*
+* File:    BMP280CompensationSimd.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/* Include Files */
+#include "BMP280CompensationSimd.h"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// The 32-bit formulas only need multiplications, additions and arithmetic
+// shifts that wrap exactly like the scalar code. The only exception is the
+// unsigned 32-bit division, which is done in double precision: both
+// operands are below 2^53, so the truncated quotient is always exact.
+
+#if defined(__AVX2__)
+
+/***
+* Function: unsignedToDouble(__m128i value)
+* Description: Convert 4 unsigned 32-bit lanes to double
+* Params: value - Values to convert
+* Returns: Converted values
+***/
+static inline __m256d unsignedToDouble(__m128i value)
+{
+	__m256d result = _mm256_cvtepi32_pd(value);
+
+	return _mm256_add_pd(result, _mm256_and_pd(_mm256_cmp_pd(result, _mm256_setzero_pd(), _CMP_LT_OQ), _mm256_set1_pd(4294967296.0)));
+}
+
+
+/***
+* Function: divideHalf(__m128i pressure, __m128i divisor)
+* Description: Pressure division step of the scalar code on 4 lanes
+* Params: pressure - Unsigned dividend
+*         divisor - Unsigned divisor (lanes with 0 are masked by the caller)
+* Returns: Quotient lanes (wrapped to 32 bits like the scalar code)
+***/
+static inline __m128i divideHalf(__m128i pressure, __m128i divisor)
+{
+	const __m256d two31 = _mm256_set1_pd(2147483648.0);
+	const __m256d two32 = _mm256_set1_pd(4294967296.0);
+	__m256d dividend = unsignedToDouble(pressure);
+	__m256d divisorD = unsignedToDouble(divisor);
+	__m256d quotientSmall, quotientLarge, quotient;
+
+	quotientSmall = _mm256_round_pd(_mm256_div_pd(_mm256_add_pd(dividend, dividend), divisorD), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); // (p << 1) / v
+	quotientLarge = _mm256_round_pd(_mm256_div_pd(dividend, divisorD), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); // (p / v) * 2
+	quotientLarge = _mm256_add_pd(quotientLarge, quotientLarge);
+	quotient = _mm256_blendv_pd(quotientLarge, quotientSmall, _mm256_cmp_pd(dividend, two31, _CMP_LT_OQ));
+
+	quotient = _mm256_sub_pd(quotient, _mm256_and_pd(_mm256_cmp_pd(quotient, two32, _CMP_GE_OQ), two32)); // Modulo 2^32
+	quotient = _mm256_sub_pd(quotient, _mm256_and_pd(_mm256_cmp_pd(quotient, two31, _CMP_GE_OQ), two32)); // Into the signed range
+
+	return _mm256_cvttpd_epi32(quotient);
+}
+
+
+void BMP280_compensateBatchSimd(const BMP280CalibrationData *calib, const int32_t *rawTemperature, const int32_t *rawPressure, int32_t *temperature, uint32_t *pressure, unsigned int count)
+{
+	const __m256i calibT1 = _mm256_set1_epi32((int32_t) calib->T1);
+	const __m256i calibT1x2 = _mm256_set1_epi32(((int32_t) calib->T1) << 1);
+	const __m256i calibT2 = _mm256_set1_epi32((int32_t) calib->T2);
+	const __m256i calibT3 = _mm256_set1_epi32((int32_t) calib->T3);
+	const __m256i calibP1 = _mm256_set1_epi32((int32_t) calib->P1);
+	const __m256i calibP2 = _mm256_set1_epi32((int32_t) calib->P2);
+	const __m256i calibP3 = _mm256_set1_epi32((int32_t) calib->P3);
+	const __m256i calibP4 = _mm256_set1_epi32(((int32_t) calib->P4) << 16);
+	const __m256i calibP5 = _mm256_set1_epi32((int32_t) calib->P5);
+	const __m256i calibP6 = _mm256_set1_epi32((int32_t) calib->P6);
+	const __m256i calibP7 = _mm256_set1_epi32((int32_t) calib->P7);
+	const __m256i calibP8 = _mm256_set1_epi32((int32_t) calib->P8);
+	const __m256i calibP9 = _mm256_set1_epi32((int32_t) calib->P9);
+	unsigned int i;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		__m256i rawT = _mm256_loadu_si256((const __m256i *) (rawTemperature + i));
+		__m256i rawP = _mm256_loadu_si256((const __m256i *) (rawPressure + i));
+		__m256i var1, var2, delta, tFine, square, invalid, pressureVal;
+
+		// t_fine
+		var1 = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(_mm256_srai_epi32(rawT, 3), calibT1x2), calibT2), 11);
+		delta = _mm256_sub_epi32(_mm256_srai_epi32(rawT, 4), calibT1);
+		var2 = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(delta, delta), 12), calibT3), 14);
+		tFine = _mm256_add_epi32(var1, var2);
+
+		_mm256_storeu_si256((__m256i *) (temperature + i), _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(tFine, _mm256_set1_epi32(5)), _mm256_set1_epi32(128)), 8));
+
+		// Pressure
+		var1 = _mm256_sub_epi32(_mm256_srai_epi32(tFine, 1), _mm256_set1_epi32(64000));
+		square = _mm256_srai_epi32(var1, 2);
+		square = _mm256_mullo_epi32(square, square);
+		var2 = _mm256_mullo_epi32(_mm256_srai_epi32(square, 11), calibP6);
+		var2 = _mm256_add_epi32(var2, _mm256_slli_epi32(_mm256_mullo_epi32(var1, calibP5), 1));
+		var2 = _mm256_add_epi32(_mm256_srai_epi32(var2, 2), calibP4);
+		var1 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(calibP3, _mm256_srai_epi32(square, 13)), 3), _mm256_srai_epi32(_mm256_mullo_epi32(calibP2, var1), 1)), 18);
+		var1 = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32(32768), var1), calibP1), 15);
+		invalid = _mm256_cmpeq_epi32(var1, _mm256_setzero_si256());
+
+		pressureVal = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_set1_epi32(1048576), rawP), _mm256_srai_epi32(var2, 12));
+		pressureVal = _mm256_mullo_epi32(pressureVal, _mm256_set1_epi32(3125));
+		pressureVal = _mm256_inserti128_si256(_mm256_castsi128_si256(divideHalf(_mm256_castsi256_si128(pressureVal), _mm256_castsi256_si128(var1))),
+						divideHalf(_mm256_extracti128_si256(pressureVal, 1), _mm256_extracti128_si256(var1, 1)), 1);
+
+		square = _mm256_srai_epi32(pressureVal, 3);
+		var1 = _mm256_srai_epi32(_mm256_mullo_epi32(calibP9, _mm256_srai_epi32(_mm256_mullo_epi32(square, square), 13)), 12);
+		var2 = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(pressureVal, 2), calibP8), 13);
+		pressureVal = _mm256_add_epi32(pressureVal, _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(var1, var2), calibP7), 4));
+
+		_mm256_storeu_si256((__m256i *) (pressure + i), _mm256_andnot_si256(invalid, pressureVal));
+	}
+
+	BMP280_compensateBatch(calib, rawTemperature + i, rawPressure + i, temperature + i, pressure + i, count - i); // Remaining samples
+}
+
+
+const char *BMP280_compensateBatchSimdName(void)
+{
+	return "AVX2";
+}
+
+#elif defined(__SSE4_1__)
+
+/***
+* Function: divideHalf(__m128i pressure, __m128i divisor)
+* Description: Pressure division step of the scalar code on the 2 low lanes
+* Params: pressure - Unsigned dividend
+*         divisor - Unsigned divisor (lanes with 0 are masked by the caller)
+* Returns: Quotient in the 2 low lanes (wrapped to 32 bits like the scalar code)
+***/
+static inline __m128i divideHalf(__m128i pressure, __m128i divisor)
+{
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d two31 = _mm_set1_pd(2147483648.0);
+	const __m128d two32 = _mm_set1_pd(4294967296.0);
+	__m128d dividend = _mm_cvtepi32_pd(pressure);
+	__m128d divisorD = _mm_cvtepi32_pd(divisor);
+	__m128d quotientSmall, quotientLarge, quotient;
+
+	dividend = _mm_add_pd(dividend, _mm_and_pd(_mm_cmplt_pd(dividend, zero), two32)); // Unsigned to double
+	divisorD = _mm_add_pd(divisorD, _mm_and_pd(_mm_cmplt_pd(divisorD, zero), two32));
+
+	quotientSmall = _mm_round_pd(_mm_div_pd(_mm_add_pd(dividend, dividend), divisorD), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); // (p << 1) / v
+	quotientLarge = _mm_round_pd(_mm_div_pd(dividend, divisorD), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); // (p / v) * 2
+	quotientLarge = _mm_add_pd(quotientLarge, quotientLarge);
+	quotient = _mm_blendv_pd(quotientLarge, quotientSmall, _mm_cmplt_pd(dividend, two31));
+
+	quotient = _mm_sub_pd(quotient, _mm_and_pd(_mm_cmpge_pd(quotient, two32), two32)); // Modulo 2^32
+	quotient = _mm_sub_pd(quotient, _mm_and_pd(_mm_cmpge_pd(quotient, two31), two32)); // Into the signed range
+
+	return _mm_cvttpd_epi32(quotient);
+}
+
+
+void BMP280_compensateBatchSimd(const BMP280CalibrationData *calib, const int32_t *rawTemperature, const int32_t *rawPressure, int32_t *temperature, uint32_t *pressure, unsigned int count)
+{
+	const __m128i calibT1 = _mm_set1_epi32((int32_t) calib->T1);
+	const __m128i calibT1x2 = _mm_set1_epi32(((int32_t) calib->T1) << 1);
+	const __m128i calibT2 = _mm_set1_epi32((int32_t) calib->T2);
+	const __m128i calibT3 = _mm_set1_epi32((int32_t) calib->T3);
+	const __m128i calibP1 = _mm_set1_epi32((int32_t) calib->P1);
+	const __m128i calibP2 = _mm_set1_epi32((int32_t) calib->P2);
+	const __m128i calibP3 = _mm_set1_epi32((int32_t) calib->P3);
+	const __m128i calibP4 = _mm_set1_epi32(((int32_t) calib->P4) << 16);
+	const __m128i calibP5 = _mm_set1_epi32((int32_t) calib->P5);
+	const __m128i calibP6 = _mm_set1_epi32((int32_t) calib->P6);
+	const __m128i calibP7 = _mm_set1_epi32((int32_t) calib->P7);
+	const __m128i calibP8 = _mm_set1_epi32((int32_t) calib->P8);
+	const __m128i calibP9 = _mm_set1_epi32((int32_t) calib->P9);
+	unsigned int i;
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		__m128i rawT = _mm_loadu_si128((const __m128i *) (rawTemperature + i));
+		__m128i rawP = _mm_loadu_si128((const __m128i *) (rawPressure + i));
+		__m128i var1, var2, delta, tFine, square, invalid, pressureVal;
+
+		// t_fine
+		var1 = _mm_srai_epi32(_mm_mullo_epi32(_mm_sub_epi32(_mm_srai_epi32(rawT, 3), calibT1x2), calibT2), 11);
+		delta = _mm_sub_epi32(_mm_srai_epi32(rawT, 4), calibT1);
+		var2 = _mm_srai_epi32(_mm_mullo_epi32(_mm_srai_epi32(_mm_mullo_epi32(delta, delta), 12), calibT3), 14);
+		tFine = _mm_add_epi32(var1, var2);
+
+		_mm_storeu_si128((__m128i *) (temperature + i), _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(tFine, _mm_set1_epi32(5)), _mm_set1_epi32(128)), 8));
+
+		// Pressure
+		var1 = _mm_sub_epi32(_mm_srai_epi32(tFine, 1), _mm_set1_epi32(64000));
+		square = _mm_srai_epi32(var1, 2);
+		square = _mm_mullo_epi32(square, square);
+		var2 = _mm_mullo_epi32(_mm_srai_epi32(square, 11), calibP6);
+		var2 = _mm_add_epi32(var2, _mm_slli_epi32(_mm_mullo_epi32(var1, calibP5), 1));
+		var2 = _mm_add_epi32(_mm_srai_epi32(var2, 2), calibP4);
+		var1 = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(_mm_mullo_epi32(calibP3, _mm_srai_epi32(square, 13)), 3), _mm_srai_epi32(_mm_mullo_epi32(calibP2, var1), 1)), 18);
+		var1 = _mm_srai_epi32(_mm_mullo_epi32(_mm_add_epi32(_mm_set1_epi32(32768), var1), calibP1), 15);
+		invalid = _mm_cmpeq_epi32(var1, _mm_setzero_si128());
+
+		pressureVal = _mm_sub_epi32(_mm_sub_epi32(_mm_set1_epi32(1048576), rawP), _mm_srai_epi32(var2, 12));
+		pressureVal = _mm_mullo_epi32(pressureVal, _mm_set1_epi32(3125));
+		pressureVal = _mm_unpacklo_epi64(divideHalf(pressureVal, var1), divideHalf(_mm_unpackhi_epi64(pressureVal, pressureVal), _mm_unpackhi_epi64(var1, var1)));
+
+		square = _mm_srai_epi32(pressureVal, 3);
+		var1 = _mm_srai_epi32(_mm_mullo_epi32(calibP9, _mm_srai_epi32(_mm_mullo_epi32(square, square), 13)), 12);
+		var2 = _mm_srai_epi32(_mm_mullo_epi32(_mm_srai_epi32(pressureVal, 2), calibP8), 13);
+		pressureVal = _mm_add_epi32(pressureVal, _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(var1, var2), calibP7), 4));
+
+		_mm_storeu_si128((__m128i *) (pressure + i), _mm_andnot_si128(invalid, pressureVal));
+	}
+
+	BMP280_compensateBatch(calib, rawTemperature + i, rawPressure + i, temperature + i, pressure + i, count - i); // Remaining samples
+}
+
+
+const char *BMP280_compensateBatchSimdName(void)
+{
+	return "SSE4.1";
+}
+
+#else
+
+void BMP280_compensateBatchSimd(const BMP280CalibrationData *calib, const int32_t *rawTemperature, const int32_t *rawPressure, int32_t *temperature, uint32_t *pressure, unsigned int count)
+{
+	BMP280_compensateBatch(calib, rawTemperature, rawPressure, temperature, pressure, count); // No SIMD support
+}
+
+
+const char *BMP280_compensateBatchSimdName(void)
+{
+	return "scalar";
+}
+
+#endif
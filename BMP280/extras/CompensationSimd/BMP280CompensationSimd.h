@@ -0,0 +1,26 @@
+/*
+* File:    BMP280CompensationSimd.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BMP280 A1
+*
+* BMP280 batch compensation for host computers (SSE4.1 / AVX2)
+*
+* Produces bit-identical results to BMP280_compensateBatch() and is
+* meant to backfill archived raw samples. It is not part of the
+* Arduino library build.
+***/
+
+#ifndef BMP280_COMPENSATION_SIMD_H
+#define BMP280_COMPENSATION_SIMD_H
+
+/* Include Files */
+#include "BMP280Compensation.h"
+
+void 		BMP280_compensateBatchSimd(const BMP280CalibrationData *calib, const int32_t *rawTemperature, const int32_t *rawPressure, int32_t *temperature, uint32_t *pressure, unsigned int count); // Compensate an array of raw samples
+const char *BMP280_compensateBatchSimdName(void); // Name of the instruction set used by BMP280_compensateBatchSimd()
+
+#endif
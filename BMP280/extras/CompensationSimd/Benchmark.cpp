@@ -0,0 +1,132 @@
+/*
+* File:    Benchmark.cpp
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* BMP280 A1
+* Batch Compensation Benchmark (host tool)
+*
+* Checks that BMP280_compensateBatchSimd() matches the scalar reference
+* BMP280_compensateBatch() bit for bit and reports the throughput of both.
+*
+* Build (from this folder):
+*   g++ -O2 -fwrapv -mavx2 -I../.. -o Benchmark Benchmark.cpp BMP280CompensationSimd.cpp ../../BMP280Compensation.cpp
+* Use -msse4.1 instead of -mavx2 for the SSE4.1 variant. -fwrapv makes the
+* host wrap signed overflows the same way the AVR does.
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "BMP280CompensationSimd.h"
+
+#define		BENCHMARK_SAMPLES				(1UL << 20)
+#define		BENCHMARK_ROUNDS				20
+
+
+/***
+* Function: nextRandom(uint32_t *state)
+* Description: Small LCG so the test vectors are the same on every host
+* Params: state - Generator state
+* Returns: Next pseudo-random value
+***/
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525UL + 1013904223UL;
+
+	return *state >> 8;
+}
+
+
+/***
+* Function: measure(bool simd, ...)
+* Description: Run one of the variants BENCHMARK_ROUNDS times
+* Returns: Throughput in samples per second
+***/
+static double measure(bool simd, const BMP280CalibrationData *calib, const int32_t *rawT, const int32_t *rawP, int32_t *temperature, uint32_t *pressure)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed;
+	int round;
+
+	for (round = 0; round < BENCHMARK_ROUNDS; round++)
+	{
+		if (simd)
+		{
+			BMP280_compensateBatchSimd(calib, rawT, rawP, temperature, pressure, BENCHMARK_SAMPLES);
+		}
+		else
+		{
+			BMP280_compensateBatch(calib, rawT, rawP, temperature, pressure, BENCHMARK_SAMPLES);
+		}
+	}
+
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	return ((double) BENCHMARK_SAMPLES * BENCHMARK_ROUNDS) / elapsed.count();
+}
+
+
+int main(void)
+{
+	// Calibration example from the datasheet (section 8.2)
+	BMP280CalibrationData calib = { 27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000 };
+	int32_t *rawT = (int32_t *) malloc(BENCHMARK_SAMPLES * sizeof(int32_t));
+	int32_t *rawP = (int32_t *) malloc(BENCHMARK_SAMPLES * sizeof(int32_t));
+	int32_t *temperatureRef = (int32_t *) malloc(BENCHMARK_SAMPLES * sizeof(int32_t));
+	int32_t *temperatureSimd = (int32_t *) malloc(BENCHMARK_SAMPLES * sizeof(int32_t));
+	uint32_t *pressureRef = (uint32_t *) malloc(BENCHMARK_SAMPLES * sizeof(uint32_t));
+	uint32_t *pressureSimd = (uint32_t *) malloc(BENCHMARK_SAMPLES * sizeof(uint32_t));
+	uint32_t state = 1;
+	unsigned long i, mismatches = 0;
+	double scalarRate, simdRate;
+
+	if ((rawT == NULL) || (rawP == NULL) || (temperatureRef == NULL) || (temperatureSimd == NULL) || (pressureRef == NULL) || (pressureSimd == NULL))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	// Raw words covering -40..85 degC and 300..1100 hPa
+	for (i = 0; i < BENCHMARK_SAMPLES; i++)
+	{
+		rawT[i] = 380000 + (int32_t) (nextRandom(&state) % 300000);
+		rawP[i] = 200000 + (int32_t) (nextRandom(&state) % 500000);
+	}
+
+	BMP280_compensateBatch(&calib, rawT, rawP, temperatureRef, pressureRef, BENCHMARK_SAMPLES);
+	BMP280_compensateBatchSimd(&calib, rawT, rawP, temperatureSimd, pressureSimd, BENCHMARK_SAMPLES);
+
+	for (i = 0; i < BENCHMARK_SAMPLES; i++)
+	{
+		if ((temperatureRef[i] != temperatureSimd[i]) || (pressureRef[i] != pressureSimd[i]))
+		{
+			if (mismatches < 10)
+			{
+				fprintf(stderr, "Mismatch at %lu: T %ld/%ld P %lu/%lu\n", i, (long) temperatureRef[i], (long) temperatureSimd[i], (unsigned long) pressureRef[i], (unsigned long) pressureSimd[i]);
+			}
+			mismatches++;
+		}
+	}
+
+	scalarRate = measure(false, &calib, rawT, rawP, temperatureRef, pressureRef);
+	simdRate = measure(true, &calib, rawT, rawP, temperatureSimd, pressureSimd);
+
+	printf("Samples:    %lu x %d\n", BENCHMARK_SAMPLES, BENCHMARK_ROUNDS);
+	printf("Mismatches: %lu\n", mismatches);
+	printf("scalar:     %.1f Msamples/s\n", scalarRate / 1e6);
+	printf("%-7s     %.1f Msamples/s (x%.2f)\n", BMP280_compensateBatchSimdName(), simdRate / 1e6, simdRate / scalarRate);
+
+	free(rawT);
+	free(rawP);
+	free(temperatureRef);
+	free(temperatureSimd);
+	free(pressureRef);
+	free(pressureSimd);
+
+	return (mismatches == 0) ? 0 : 1;
+}
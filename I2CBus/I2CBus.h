@@ -0,0 +1,434 @@
+/*
+* File:    I2CBus.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* I2CBus A1
+*
+* Register access layer shared by the sensor drivers.
+*
+* I2CBus<address, byteOrder, timeoutUs, Backend> gives a driver bounded
+* time register reads and writes with retries and error counters. Every
+* member is static, so a driver only needs a typedef and each device gets
+* its own set of counters. Register reads use a combined write-then-read
+* transaction (repeated start) and any number of bytes can be read in
+* one burst.
+*
+* The backend does the actual bus operations. I2CWireBackend uses the
+* Arduino Wire library; any class with the same static functions can
+* replace it (e.g. a software I2C or a simulated bus).
+***/
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+/* Include Files */
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <Wire.h>
+
+//#define	I2C_BUS_TRACE // Uncomment to profile the bus traffic of each driver call (see I2CBusTrace.h)
+
+#include "I2CBusTrace.h"
+
+// Byte order of 16-bit registers
+#define		I2C_BUS_MSB_FIRST						0
+#define		I2C_BUS_LSB_FIRST						1
+
+#define		I2C_BUS_MAX_RETRIES						2 // Retries after a NACK or timeout
+
+// Result codes (same as Wire.endTransmission())
+#define		I2C_BUS_OK								0
+#define		I2C_BUS_ERROR_ADDRESS_NACK				2
+#define		I2C_BUS_ERROR_DATA_NACK					3
+#define		I2C_BUS_ERROR_TIMEOUT					5
+
+// Worst case duration of one transaction (each attempt is a write, a read and the wait for the bytes)
+#define		I2C_BUS_TRANSACTION_MAX_US(timeoutUs)	((I2C_BUS_MAX_RETRIES + 1) * 3UL * (timeoutUs))
+
+
+/***
+* I2CWireBackend
+* Bus operations using the Arduino Wire library
+***/
+class I2CWireBackend
+{
+	public:
+		/***
+		* Function: begin(void)
+		* Description: Initialize the bus
+		* Params: none
+		* Returns: none
+		***/
+		static void begin(void)
+		{
+			Wire.begin();
+		}
+
+		/***
+		* Function: probe(byte address, unsigned long timeoutUs)
+		* Description: Address a device without sending data
+		* Params: address - Device address
+		*         timeoutUs - Maximum duration of the operation
+		* Returns: I2C_BUS_OK if the device answered, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte probe(byte address, unsigned long timeoutUs)
+		{
+#if defined(WIRE_HAS_TIMEOUT)
+			Wire.setWireTimeout(timeoutUs, true); // Bound the time spent inside the Wire library
+#else
+			(void) timeoutUs;
+#endif
+			Wire.beginTransmission(address);
+
+			return Wire.endTransmission();
+		}
+
+		/***
+		* Function: write(byte address, byte reg, const byte *array, byte length, bool sendStop, unsigned long timeoutUs)
+		* Description: Write a register address (or command) followed by data
+		* Params: address - Device address
+		*         reg - Register address or command
+		*         array - Bytes to write after the register address
+		*         length - Number of bytes in array (may be 0)
+		*         sendStop - false to keep the bus for a repeated start
+		*         timeoutUs - Maximum duration of the operation
+		* Returns: I2C_BUS_OK or an I2C_BUS_ERROR_ code
+		***/
+		static byte write(byte address, byte reg, const byte *array, byte length, bool sendStop, unsigned long timeoutUs)
+		{
+#if defined(WIRE_HAS_TIMEOUT)
+			Wire.setWireTimeout(timeoutUs, true); // Bound the time spent inside the Wire library
+#else
+			(void) timeoutUs;
+#endif
+			Wire.beginTransmission(address);
+			Wire.write(reg);
+			if (length > 0)
+			{
+				Wire.write(array, length);
+			}
+
+			return Wire.endTransmission(sendStop);
+		}
+
+		/***
+		* Function: read(byte address, byte *array, byte length, unsigned long timeoutUs)
+		* Description: Read bytes from a device
+		* Params: address - Device address
+		*         array - Variable to save the values in
+		*         length - Number of bytes to read
+		*         timeoutUs - Maximum duration of the operation
+		* Returns: I2C_BUS_OK, I2C_BUS_ERROR_ADDRESS_NACK if the device did not answer
+		*          or I2C_BUS_ERROR_TIMEOUT
+		***/
+		static byte read(byte address, byte *array, byte length, unsigned long timeoutUs)
+		{
+			byte received;
+			byte byteCount;
+			unsigned long time;
+
+#if defined(WIRE_HAS_TIMEOUT)
+			Wire.setWireTimeout(timeoutUs, true);
+#endif
+			received = Wire.requestFrom(address, length);
+
+			time = micros(); // Timestamp
+			while((received > 0) && (Wire.available() < length) && ((micros() - time) < timeoutUs)) ; // Wait until bytes are ready or the timeout expires (no wait after a NACK)
+
+			if (Wire.available() >= length)
+			{
+				for (byteCount = 0; byteCount < length; byteCount++)
+				{
+					array[byteCount] = Wire.read(); // Read byte
+				}
+				return I2C_BUS_OK;
+			}
+
+			while(Wire.available()) // Discard incomplete data
+			{
+				Wire.read();
+			}
+
+#if defined(WIRE_HAS_TIMEOUT)
+			if (Wire.getWireTimeoutFlag())
+			{
+				Wire.clearWireTimeoutFlag();
+				return I2C_BUS_ERROR_TIMEOUT;
+			}
+#endif
+
+			return (received == 0) ? I2C_BUS_ERROR_ADDRESS_NACK : I2C_BUS_ERROR_TIMEOUT;
+		}
+};
+
+
+/***
+* I2CBus
+* Register access to one device
+*   address - 7-bit device address
+*   byteOrder - I2C_BUS_MSB_FIRST or I2C_BUS_LSB_FIRST (16-bit registers)
+*   timeoutUs - Maximum duration of each bus operation
+*   Backend - Class that does the bus operations
+***/
+template<byte address, byte byteOrder, unsigned long timeoutUs, class Backend = I2CWireBackend>
+class I2CBus
+{
+	public:
+		/***
+		* Function: begin(void)
+		* Description: Initialize the bus
+		* Params: none
+		* Returns: none
+		***/
+		static void begin(void)
+		{
+			Backend::begin();
+		}
+
+		/***
+		* Function: probe(void)
+		* Description: Check if the device answers its address (no retries)
+		* Params: none
+		* Returns: I2C_BUS_OK if the device answered, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte probe(void)
+		{
+			_transactionCount++;
+			I2C_BUS_TRACE_TRANSFER(0);
+
+			return Backend::probe(address, timeoutUs);
+		}
+
+		/***
+		* Function: readRegisters(byte reg, byte *array, byte length)
+		* Description: Burst read of consecutive registers (write the register
+		*              address, repeated start, read)
+		* Params: reg - Register address or command
+		*         array - Variable to save the values in
+		*         length - Number of bytes to read
+		* Returns: I2C_BUS_OK if the values were read successfully, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte readRegisters(byte reg, byte *array, byte length)
+		{
+			byte result = I2C_BUS_OK;
+			byte attempt;
+
+			for (attempt = 0; attempt <= I2C_BUS_MAX_RETRIES; attempt++)
+			{
+				if (attempt > 0)
+				{
+					_retryCount++;
+				}
+
+				result = Backend::write(address, reg, 0, 0, false, timeoutUs);
+				_transactionCount++;
+				I2C_BUS_TRACE_TRANSFER(1);
+
+				if (result == I2C_BUS_OK)
+				{
+					result = Backend::read(address, array, length, timeoutUs);
+					_transactionCount++;
+					I2C_BUS_TRACE_TRANSFER((result == I2C_BUS_OK) ? length : 0);
+				}
+
+				if (result == I2C_BUS_OK)
+				{
+					return I2C_BUS_OK;
+				}
+
+				countError(result);
+			}
+
+			return result;
+		}
+
+		/***
+		* Function: read(byte *array, byte length)
+		* Description: Read bytes without writing a register address first
+		*              (e.g. result of a previous command). Not retried and
+		*              an address NACK is not counted as an error, so it can
+		*              be used as a "not ready" answer when polling.
+		* Params: array - Variable to save the values in
+		*         length - Number of bytes to read
+		* Returns: I2C_BUS_OK if the values were read successfully, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte read(byte *array, byte length)
+		{
+			byte result;
+
+			result = Backend::read(address, array, length, timeoutUs);
+			_transactionCount++;
+			I2C_BUS_TRACE_TRANSFER((result == I2C_BUS_OK) ? length : 0);
+
+			if ((result != I2C_BUS_OK) && (result != I2C_BUS_ERROR_ADDRESS_NACK))
+			{
+				countError(result);
+			}
+
+			return result;
+		}
+
+		/***
+		* Function: readByte(byte reg, byte *value)
+		* Description: Read one register
+		* Params: reg - Register address or command
+		*         value - Variable to save the value in
+		* Returns: I2C_BUS_OK if the value was read successfully, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte readByte(byte reg, byte *value)
+		{
+			return readRegisters(reg, value, 1);
+		}
+
+		/***
+		* Function: readUInt(byte reg, unsigned short *value)
+		* Description: Read a 16-bit unsigned register in the device byte order
+		* Params: reg - Register address or command
+		*         value - Variable to save the value in
+		* Returns: I2C_BUS_OK if the value was read successfully, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte readUInt(byte reg, unsigned short *value)
+		{
+			byte result;
+			byte data[2];
+
+			result = readRegisters(reg, data, 2);
+
+			if (result == I2C_BUS_OK)
+			{
+				*value = toUInt(data);
+			}
+
+			return result;
+		}
+
+		/***
+		* Function: readInt(byte reg, signed short *value)
+		* Description: Read a 16-bit signed register in the device byte order
+		* Params: reg - Register address or command
+		*         value - Variable to save the value in
+		* Returns: I2C_BUS_OK if the value was read successfully, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte readInt(byte reg, signed short *value)
+		{
+			return readUInt(reg, (unsigned short *) value);
+		}
+
+		/***
+		* Function: writeRegisters(byte reg, const byte *array, byte length)
+		* Description: Write consecutive registers in one transaction
+		* Params: reg - Register address or command
+		*         array - Values to write
+		*         length - Number of bytes to write (0 sends only the command)
+		* Returns: I2C_BUS_OK if the values were written successfully, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte writeRegisters(byte reg, const byte *array, byte length)
+		{
+			byte result = I2C_BUS_OK;
+			byte attempt;
+
+			for (attempt = 0; attempt <= I2C_BUS_MAX_RETRIES; attempt++)
+			{
+				if (attempt > 0)
+				{
+					_retryCount++;
+				}
+
+				result = Backend::write(address, reg, array, length, true, timeoutUs);
+				_transactionCount++;
+				I2C_BUS_TRACE_TRANSFER(1 + length);
+
+				if (result == I2C_BUS_OK)
+				{
+					return I2C_BUS_OK;
+				}
+
+				countError(result);
+			}
+
+			return result;
+		}
+
+		/***
+		* Function: writeByte(byte reg, byte value)
+		* Description: Write one register
+		* Params: reg - Register address or command
+		*         value - Value to write
+		* Returns: I2C_BUS_OK if the value was written successfully, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte writeByte(byte reg, byte value)
+		{
+			return writeRegisters(reg, &value, 1);
+		}
+
+		/***
+		* Function: writeCommand(byte command)
+		* Description: Send a command byte without data
+		* Params: command - Command to send
+		* Returns: I2C_BUS_OK if the command was acknowledged, an I2C_BUS_ERROR_ code if not
+		***/
+		static byte writeCommand(byte command)
+		{
+			return writeRegisters(command, 0, 0);
+		}
+
+		/***
+		* Function: toUInt(const byte *data)
+		* Description: Assemble a 16-bit value in the device byte order
+		* Params: data - Two bytes as read from the device
+		* Returns: 16-bit value
+		***/
+		static unsigned short toUInt(const byte *data)
+		{
+			if (byteOrder == I2C_BUS_MSB_FIRST)
+			{
+				return (((unsigned short) data[0]) << 8) | data[1];
+			}
+
+			return (((unsigned short) data[1]) << 8) | data[0];
+		}
+
+		static unsigned long getTransactionCount(void) { return _transactionCount; } // Number of bus operations (each write and each read counts as one)
+		static void resetTransactionCount(void) { _transactionCount = 0; }
+		static unsigned int getNackCount(void) { return _nackCount; } // Number of operations not acknowledged by the device
+		static unsigned int getTimeoutCount(void) { return _timeoutCount; } // Number of operations that timed out
+		static unsigned int getRetryCount(void) { return _retryCount; } // Number of retried transactions
+		static void resetErrorCounters(void) { _nackCount = 0; _timeoutCount = 0; _retryCount = 0; }
+
+	private:
+		static unsigned long _transactionCount;
+		static unsigned int _nackCount, _timeoutCount, _retryCount;
+
+		static void countError(byte result)
+		{
+			if (result == I2C_BUS_ERROR_TIMEOUT)
+			{
+				_timeoutCount++;
+			}
+			else
+			{
+				_nackCount++;
+			}
+		}
+};
+
+template<byte address, byte byteOrder, unsigned long timeoutUs, class Backend>
+unsigned long I2CBus<address, byteOrder, timeoutUs, Backend>::_transactionCount = 0;
+
+template<byte address, byte byteOrder, unsigned long timeoutUs, class Backend>
+unsigned int I2CBus<address, byteOrder, timeoutUs, Backend>::_nackCount = 0;
+
+template<byte address, byte byteOrder, unsigned long timeoutUs, class Backend>
+unsigned int I2CBus<address, byteOrder, timeoutUs, Backend>::_timeoutCount = 0;
+
+template<byte address, byte byteOrder, unsigned long timeoutUs, class Backend>
+unsigned int I2CBus<address, byteOrder, timeoutUs, Backend>::_retryCount = 0;
+
+#endif
@@ -0,0 +1,202 @@
+/*
+* File:    I2CBusTrace.h
+* Author:  Hugo Cunha
+* Company: Globaltronic SA
+*/
+
+/***
+* I2CBus A1
+*
+* Optional per-call bus profiler.
+*
+* Enable it by uncommenting I2C_BUS_TRACE in I2CBus.h. Drivers mark their
+* public functions with I2C_BUS_TRACE_CALL("Class::function"); every I2C
+* transaction and byte moved by I2CBus, and the time spent, is charged to
+* the innermost marked call (nested calls are subtracted from their
+* caller). I2C_BUS_TRACE_REPORT() marks a call that prints the table to
+* I2C_BUS_TRACE_SERIAL and clears it when it returns.
+*
+* When I2C_BUS_TRACE is not defined all the macros are empty.
+***/
+
+#ifndef I2C_BUS_TRACE_H
+#define I2C_BUS_TRACE_H
+
+#ifdef I2C_BUS_TRACE
+
+#define		I2C_BUS_TRACE_MAX_ENTRIES				24 // Different functions recorded
+#ifndef I2C_BUS_TRACE_SERIAL
+#define		I2C_BUS_TRACE_SERIAL					Serial
+#endif
+
+class I2CBusTraceScope;
+
+/* Totals of one function */
+typedef struct
+{
+	const char		*name;
+	unsigned int	calls;
+	unsigned long	transactions; // Own transactions (nested calls excluded)
+	unsigned long	bytes; // Own bytes written and read
+	unsigned long	selfUs; // Own time
+	unsigned long	totalUs; // Time including nested calls
+} I2CBusTraceEntry;
+
+/* Counters shared by all devices */
+typedef struct
+{
+	unsigned long	transactions;
+	unsigned long	bytes;
+	I2CBusTraceEntry entries[I2C_BUS_TRACE_MAX_ENTRIES];
+	byte			entryCount;
+	I2CBusTraceScope *current; // Innermost running call
+} I2CBusTraceData;
+
+
+class I2CBusTrace
+{
+	public:
+		static I2CBusTraceData &data(void)
+		{
+			static I2CBusTraceData traceData; // One instance, zero-initialized
+
+			return traceData;
+		}
+
+		/***
+		* Function: transfer(unsigned int bytes)
+		* Description: Count one transaction (called by I2CBus)
+		***/
+		static void transfer(unsigned int bytes)
+		{
+			data().transactions++;
+			data().bytes += bytes;
+		}
+
+		static I2CBusTraceEntry *find(const char *name)
+		{
+			I2CBusTraceData &trace = data();
+			byte i;
+
+			for (i = 0; i < trace.entryCount; i++)
+			{
+				if (trace.entries[i].name == name)
+				{
+					return &trace.entries[i];
+				}
+			}
+
+			if (trace.entryCount >= I2C_BUS_TRACE_MAX_ENTRIES)
+			{
+				return 0; // Table full
+			}
+
+			memset(&trace.entries[trace.entryCount], 0, sizeof(I2CBusTraceEntry)); // No totals left from a previous report
+			trace.entries[trace.entryCount].name = name;
+			return &trace.entries[trace.entryCount++];
+		}
+
+		/***
+		* Function: dump(void)
+		* Description: Print the table and clear it
+		***/
+		static void dump(void)
+		{
+			I2CBusTraceData &trace = data();
+			byte i;
+
+			I2C_BUS_TRACE_SERIAL.println("I2C trace: call\tcalls\ttrans\tbytes\tself_us\ttotal_us");
+			for (i = 0; i < trace.entryCount; i++)
+			{
+				I2C_BUS_TRACE_SERIAL.print(trace.entries[i].name);
+				I2C_BUS_TRACE_SERIAL.print('\t');
+				I2C_BUS_TRACE_SERIAL.print(trace.entries[i].calls);
+				I2C_BUS_TRACE_SERIAL.print('\t');
+				I2C_BUS_TRACE_SERIAL.print(trace.entries[i].transactions);
+				I2C_BUS_TRACE_SERIAL.print('\t');
+				I2C_BUS_TRACE_SERIAL.print(trace.entries[i].bytes);
+				I2C_BUS_TRACE_SERIAL.print('\t');
+				I2C_BUS_TRACE_SERIAL.print(trace.entries[i].selfUs);
+				I2C_BUS_TRACE_SERIAL.print('\t');
+				I2C_BUS_TRACE_SERIAL.println(trace.entries[i].totalUs);
+			}
+
+			memset(trace.entries, 0, sizeof(trace.entries));
+			trace.entryCount = 0;
+		}
+};
+
+
+/* Marks one running call (lives on the stack of the traced function) */
+class I2CBusTraceScope
+{
+	public:
+		I2CBusTraceScope(const char *name, bool report = false)
+		{
+			I2CBusTraceData &trace = I2CBusTrace::data();
+
+			_name = name;
+			_report = report;
+			_parent = trace.current;
+			_childTransactions = 0;
+			_childBytes = 0;
+			_childUs = 0;
+			_startTransactions = trace.transactions;
+			_startBytes = trace.bytes;
+			trace.current = this;
+			_startUs = micros();
+		}
+
+		~I2CBusTraceScope()
+		{
+			unsigned long elapsedUs = micros() - _startUs;
+			I2CBusTraceData &trace = I2CBusTrace::data();
+			unsigned long transactions = trace.transactions - _startTransactions;
+			unsigned long bytes = trace.bytes - _startBytes;
+			I2CBusTraceEntry *entry = I2CBusTrace::find(_name);
+
+			if (entry != 0)
+			{
+				entry->calls++;
+				entry->transactions += transactions - _childTransactions;
+				entry->bytes += bytes - _childBytes;
+				entry->selfUs += elapsedUs - _childUs;
+				entry->totalUs += elapsedUs;
+			}
+
+			if (_parent != 0)
+			{
+				_parent->_childTransactions += transactions;
+				_parent->_childBytes += bytes;
+				_parent->_childUs += elapsedUs;
+			}
+			trace.current = _parent;
+
+			if (_report)
+			{
+				I2CBusTrace::dump();
+			}
+		}
+
+	private:
+		const char			*_name;
+		bool				_report;
+		I2CBusTraceScope	*_parent;
+		unsigned long		_startUs, _childUs;
+		unsigned long		_startTransactions, _childTransactions;
+		unsigned long		_startBytes, _childBytes;
+};
+
+#define		I2C_BUS_TRACE_CALL(name)				I2CBusTraceScope i2cBusTraceScope(name)
+#define		I2C_BUS_TRACE_REPORT(name)				I2CBusTraceScope i2cBusTraceScope(name, true)
+#define		I2C_BUS_TRACE_TRANSFER(bytes)			I2CBusTrace::transfer(bytes)
+
+#else
+
+#define		I2C_BUS_TRACE_CALL(name)
+#define		I2C_BUS_TRACE_REPORT(name)
+#define		I2C_BUS_TRACE_TRANSFER(bytes)
+
+#endif
+
+#endif
@@ -7,23 +7,56 @@
 /* Include Files */
 #include "SWClock.h"
 
-byte SWClockMonthsLength[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+const byte SWClockMonthsLength[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+/* Date and time formats: blank string and position of year, month, day, hour, minute and second */
+const char SWClockFormatTemplates[3][SWCLOCK_STRING_LENGTH] PROGMEM =
+{
+	"0000/00/00-00:00:00",	// SWCLOCK_FORMAT_DEFAULT
+	"0000-00-00T00:00:00",	// SWCLOCK_FORMAT_ISO8601
+	"00000000000000"		// SWCLOCK_FORMAT_COMPACT
+};
+const byte SWClockFormatFields[3][6] PROGMEM =
+{
+	{ 0, 5, 8, 11, 14, 17 },
+	{ 0, 5, 8, 11, 14, 17 },
+	{ 0, 4, 6, 8, 10, 12 }
+};
+
+/***
+* Function: SWClock_writeDigits(char *output, unsigned int value, byte digits)
+* Description: Write a number with leading zeros
+* Params: 	output - First character of the field
+*			value - Number
+*			digits - Field width
+* Returns: none
+***/
+static void SWClock_writeDigits(char *output, unsigned int value, byte digits)
+{
+	while (digits > 0)
+	{
+		digits--;
+		output[digits] = '0' + (value % 10);
+		value /= 10;
+	}
+}
 
 SWClock::SWClock()
 {
-	second = 0;
-	minute = 0;
-	hour = 0;
-	day = 0;
-	month = 0;
-	year = 0;
+	epoch = 0;
 	initialized = false;
+	drift = 0;
+	driftAccumulator = 0;
+	syncElapsed = 0;
+	formatted[0] = '\0';
+	formattedEpoch = 0;
+	formattedFormat = SWCLOCK_FORMAT_NONE;
 }
 
 /***
 * Function: begin(int newYear, int newMonth, int newDay, int newHour, int newMinute, int newSecond)
 * Description: Initializes SW Clock
-* Params: 	newYear - Year
+* Params: 	newYear - Year (1970 to 2105)
 *			newMonth - Month
 *			newDay - Day
 *			newHour - Hour
@@ -33,20 +66,30 @@ SWClock::SWClock()
 ***/
 void SWClock::begin(int newYear, int newMonth, int newDay, int newHour, int newMinute, int newSecond)
 {
-	year = newYear;
-	month = constrain(newMonth, 1, 12);
-	day = constrain(newDay,1, SWClockMonthsLength[month - 1]);
-	hour = constrain(newHour, 0, 23);
-	minute = constrain(newMinute, 0, 59);
-	second = constrain(newSecond, 0, 59);
+	int clockYear = constrain(newYear, SWCLOCK_EPOCH_YEAR, 2105);
+	byte clockMonth = constrain(newMonth, 1, 12);
+	byte clockDay = constrain(newDay, 1, getMonthLength(clockYear, clockMonth));
+	
+	epoch = daysFromCivil(clockYear, clockMonth, clockDay) * SWCLOCK_SECONDS_PER_DAY;
+	epoch += (unsigned long) constrain(newHour, 0, 23) * 3600;
+	epoch += (unsigned long) constrain(newMinute, 0, 59) * 60;
+	epoch += constrain(newSecond, 0, 59);
 	
+	driftAccumulator = 0;
+	syncElapsed = 0;
 	initialized = true;
 }
 
+/***
+* Function: begin(char *string)
+* Description: Initializes SW Clock from a "YYYY/MM/DD-hh:mm:ss" string
+* Params: 	string - Date and time (modified by strtok)
+* Returns: none
+***/
 void SWClock::begin(char *string)
 {
-	char *str = "0000";
-	int clockYear, clockMonth, clockDay, clockHour, clockMinute, clockSecond;
+	char *str;
+	int clockYear = SWCLOCK_EPOCH_YEAR, clockMonth = 1, clockDay = 1, clockHour = 0, clockMinute = 0, clockSecond = 0;
 	
 	str = strtok(string, "/-:");
 	
@@ -84,68 +127,336 @@ void SWClock::begin(char *string)
 	begin(clockYear, clockMonth, clockDay, clockHour, clockMinute, clockSecond);
 }
 
+/***
+* Function: begin(unsigned long epochSeconds)
+* Description: Initializes SW Clock from a timestamp
+* Params: 	epochSeconds - Seconds since 1970/01/01-00:00:00
+* Returns: none
+***/
+void SWClock::begin(unsigned long epochSeconds)
+{
+	epoch = epochSeconds;
+	driftAccumulator = 0;
+	syncElapsed = 0;
+	initialized = true;
+}
+
 bool SWClock::isInitialized()
 {
 	return initialized;
 }
 
+/***
+* Function: addTime(int sumYear, int sumMonth, int sumDay, int sumHour, int sumMinute, int sumSecond)
+* Description: Add (or subtract) time. Days, hours, minutes and seconds are
+*              a single addition; years and months keep the day of the
+*              month (limited to the length of the new month).
+*              This is a manual adjustment: no drift correction is added
+*              and the drift learning interval of sync() restarts.
+* Params: 	sumYear - Years
+*			sumMonth - Months
+*			sumDay - Days
+*			sumHour - Hours
+*			sumMinute - Minutes
+*			sumSecond - Seconds
+* Returns: 0
+***/
 byte SWClock::addTime(int sumYear, int sumMonth, int sumDay, int sumHour, int sumMinute, int sumSecond)
 {
-	second += sumSecond;
-	minute += sumMinute;
-	hour += sumHour;
-	day += sumDay;
-	month += sumMonth;
-	year += sumYear;
+	unsigned long timeOfDay;
+	long months;
+	int clockYear;
+	byte clockMonth, clockDay;
+	
+	if ((sumYear != 0) || (sumMonth != 0))
+	{
+		timeOfDay = epoch % SWCLOCK_SECONDS_PER_DAY;
+		civilFromDays(epoch / SWCLOCK_SECONDS_PER_DAY, &clockYear, &clockMonth, &clockDay);
+		
+		months = ((long) clockYear + sumYear) * 12 + (clockMonth - 1) + sumMonth;
+		clockYear = months / 12;
+		clockMonth = (months % 12) + 1;
+		if (clockDay > getMonthLength(clockYear, clockMonth))
+		{
+			clockDay = getMonthLength(clockYear, clockMonth);
+		}
+		
+		epoch = daysFromCivil(clockYear, clockMonth, clockDay) * SWCLOCK_SECONDS_PER_DAY + timeOfDay;
+	}
+	
+	epoch += ((long) sumDay * SWCLOCK_SECONDS_PER_DAY) + ((long) sumHour * 3600) + ((long) sumMinute * 60) + sumSecond;
+	syncElapsed = 0;
+	
+	return 0;
+}
+
+/***
+* Function: addSeconds(unsigned long seconds)
+* Description: Advance the clock by the elapsed time plus the drift
+*              correction. The fraction of a second of the correction
+*              is kept for the next call.
+* Params: 	seconds - Elapsed seconds
+* Returns: none
+***/
+void SWClock::addSeconds(unsigned long seconds)
+{
+	long correction;
 	
-	while(second >= 60)
+	driftAccumulator += (long long) seconds * drift;
+	correction = driftAccumulator / SWCLOCK_NS_PER_SECOND; // Whole seconds, rounded toward zero
+	driftAccumulator -= (long long) correction * SWCLOCK_NS_PER_SECOND;
+	
+	epoch += seconds + correction;
+	syncElapsed += seconds;
+}
+
+/***
+* Function: getEpoch()
+* Description: Get the date and time as a 4 byte timestamp
+* Params: 	none
+* Returns: Seconds since 1970/01/01-00:00:00
+***/
+unsigned long SWClock::getEpoch()
+{
+	return epoch;
+}
+
+/***
+* Function: setDrift(long driftPpb)
+* Description: Set the drift correction
+* Params: 	driftPpb - Correction in ppb (1000 ppb = 1 ppm), positive if the
+*			           clock runs slow (limited to +/-SWCLOCK_DRIFT_MAX_PPB)
+* Returns: none
+***/
+void SWClock::setDrift(long driftPpb)
+{
+	drift = constrain(driftPpb, -SWCLOCK_DRIFT_MAX_PPB, SWCLOCK_DRIFT_MAX_PPB);
+}
+
+/***
+* Function: setDriftString(char *string)
+* Description: Set the drift correction from a "[-]ppm[.ppm]" string, up
+*              to 3 decimal places (e.g. "-12.5")
+* Params: 	string - Correction in ppm, positive if the clock runs slow
+* Returns: none
+***/
+void SWClock::setDriftString(char *string)
+{
+	long driftPpb = 0;
+	bool negative = false, fraction = false;
+	byte decimals = 0;
+	
+	while (*string == ' ')
 	{
-		second -= 60;
-		minute++;
+		string++;
+	}
+	if ((*string == '-') || (*string == '+'))
+	{
+		negative = (*string == '-');
+		string++;
 	}
 	
-	while(minute >= 60)
+	for (; *string != '\0'; string++)
 	{
-		minute -= 60;
-		hour++;
+		if ((*string == '.') && (fraction == false))
+		{
+			fraction = true;
+		}
+		else if ((*string >= '0') && (*string <= '9'))
+		{
+			if (decimals == 3)
+			{
+				break;
+			}
+			if (driftPpb <= SWCLOCK_DRIFT_MAX_PPB)
+			{
+				driftPpb = (driftPpb * 10) + (*string - '0');
+			}
+			if (fraction == true)
+			{
+				decimals++;
+			}
+		}
+		else
+		{
+			break;
+		}
 	}
 	
-	while(hour >= 24)
+	for (; decimals < 3; decimals++)
+	{
+		if (driftPpb <= SWCLOCK_DRIFT_MAX_PPB)
+		{
+			driftPpb *= 10;
+		}
+	}
+	
+	setDrift(negative ? -driftPpb : driftPpb);
+}
+
+/***
+* Function: getDrift()
+* Description: Get the drift correction
+* Params: 	none
+* Returns: Correction in ppb (1000 ppb = 1 ppm)
+***/
+long SWClock::getDrift()
+{
+	return drift;
+}
+
+/***
+* Function: sync(unsigned long referenceEpoch)
+* Description: Set the clock from a reference time. If at least
+*              SWCLOCK_SYNC_MIN_SECONDS were added with addSeconds() since
+*              begin() or the last sync(), the error (fraction of a second
+*              of the correction included) is added to the drift.
+* Params: 	referenceEpoch - Reference time, seconds since 1970/01/01-00:00:00
+* Returns: 0 - Drift updated
+*          1 - Clock set only (not initialized or interval too short)
+***/
+byte SWClock::sync(unsigned long referenceEpoch)
+{
+	long long errorNs, learnedDrift;
+	byte result = 1;
+	
+	if ((initialized == true) && (syncElapsed >= SWCLOCK_SYNC_MIN_SECONDS))
 	{
-		hour -= 24;
-		day++;
+		errorNs = ((long long) referenceEpoch - (long long) epoch) * SWCLOCK_NS_PER_SECOND - driftAccumulator;
+		learnedDrift = drift + (errorNs / (long long) syncElapsed); // ns per second = ppb
+		setDrift(constrain(learnedDrift, -SWCLOCK_DRIFT_MAX_PPB, SWCLOCK_DRIFT_MAX_PPB));
+		result = 0;
 	}
 	
+	begin(referenceEpoch);
 	
-	while(day > SWClockMonthsLength[month - 1])
+	return result;
+}
+
+/***
+* Function: getDateTime(int *outYear, byte *outMonth, byte *outDay, byte *outHour, byte *outMinute, byte *outSecond)
+* Description: Get the calendar date and time
+* Params: 	outYear, outMonth, outDay, outHour, outMinute, outSecond - Outputs
+* Returns: none
+***/
+void SWClock::getDateTime(int *outYear, byte *outMonth, byte *outDay, byte *outHour, byte *outMinute, byte *outSecond)
+{
+	unsigned long timeOfDay = epoch % SWCLOCK_SECONDS_PER_DAY;
+	
+	civilFromDays(epoch / SWCLOCK_SECONDS_PER_DAY, outYear, outMonth, outDay);
+	*outHour = timeOfDay / 3600;
+	*outMinute = (timeOfDay / 60) % 60;
+	*outSecond = timeOfDay % 60;
+}
+
+/***
+* Function: getDateTimeString(char *output)
+* Description: Get the date and time as "YYYY/MM/DD-hh:mm:ss"
+* Params: 	output - Buffer of at least SWCLOCK_STRING_LENGTH chars
+* Returns: none
+***/
+void SWClock::getDateTimeString(char *output)
+{
+	strcpy(output, formatDateTime(SWCLOCK_FORMAT_DEFAULT));
+}
+
+/***
+* Function: formatDateTime(byte format)
+* Description: Format the date and time. The string of the previous call
+*              is kept and only the fields that changed are rewritten: the
+*              date when the day changes, hours and minutes when the minute
+*              changes. Going back in time or changing the format renders
+*              the whole string.
+* Params: 	format - SWCLOCK_FORMAT_DEFAULT, SWCLOCK_FORMAT_ISO8601,
+*			         SWCLOCK_FORMAT_COMPACT or SWCLOCK_FORMAT_EPOCH
+* Returns: String, valid until the next call
+***/
+const char *SWClock::formatDateTime(byte format)
+{
+	unsigned long days = epoch / SWCLOCK_SECONDS_PER_DAY;
+	unsigned int minuteOfDay = (epoch % SWCLOCK_SECONDS_PER_DAY) / 60;
+	byte second = epoch % 60;
+	const byte *fields;
+	int clockYear;
+	byte clockMonth, clockDay;
+	bool full;
+	
+	if (format > SWCLOCK_FORMAT_EPOCH)
 	{
-		if ((month == 2) && (isLeapYear(year) == true))
+		format = SWCLOCK_FORMAT_DEFAULT;
+	}
+	full = (format != formattedFormat) || (epoch < formattedEpoch);
+	
+	if (format == SWCLOCK_FORMAT_EPOCH)
+	{
+		formatEpoch(full);
+	}
+	else
+	{
+		fields = SWClockFormatFields[format];
+		
+		if (full == true)
 		{
-			SWClockMonthsLength[month - 1] = 29;
+			strcpy_P(formatted, SWClockFormatTemplates[format]);
 		}
 		
-		day -= SWClockMonthsLength[month - 1];
-		month++;
+		if ((full == true) || (days != formattedEpoch / SWCLOCK_SECONDS_PER_DAY))
+		{
+			civilFromDays(days, &clockYear, &clockMonth, &clockDay);
+			SWClock_writeDigits(&formatted[pgm_read_byte(&fields[0])], clockYear, 4);
+			SWClock_writeDigits(&formatted[pgm_read_byte(&fields[1])], clockMonth, 2);
+			SWClock_writeDigits(&formatted[pgm_read_byte(&fields[2])], clockDay, 2);
+			full = true;
+		}
 		
-		if(month > 12)
+		if ((full == true) || (formattedEpoch < epoch - second))
 		{
-			month = 1;
-			year++;
+			SWClock_writeDigits(&formatted[pgm_read_byte(&fields[3])], minuteOfDay / 60, 2);
+			SWClock_writeDigits(&formatted[pgm_read_byte(&fields[4])], minuteOfDay % 60, 2);
 		}
+		
+		SWClock_writeDigits(&formatted[pgm_read_byte(&fields[5])], second, 2);
 	}
 	
-	while(month > 12)
-	{
-		month -= 12;
-		year++;
-	}
+	formattedEpoch = epoch;
+	formattedFormat = format;
+	
+	return formatted;
 }
 
-void SWClock::getDateTimeString(char *output)
+/***
+* Function: formatEpoch(bool full)
+* Description: Write the timestamp in decimal. Only the digits that differ
+*              from the previous timestamp are rewritten, unless full is
+*              set or the number of digits changed.
+* Params: 	full - Render the whole string
+* Returns: none
+***/
+void SWClock::formatEpoch(bool full)
 {
-	sprintf(output, "%4d/%02d/%02d-%02d:%02d:%02d", year, month, day, hour, minute, second);
+	unsigned long value = epoch, previous = formattedEpoch;
+	byte length = 0;
+	
+	do
+	{
+		length++;
+		value /= 10;
+	} while (value > 0);
+	
+	if ((full == true) || (formatted[length] != '\0') || (formatted[length - 1] == '\0'))
+	{
+		formatted[length] = '\0'; // Number of digits changed
+		full = true;
+	}
 	
-	//*output = String(year) + "/" + String(month) + "/" + String(day) + "-" + String(hour) + ":" + String(minute) + ":" + String(second);
+	value = epoch;
+	while ((length > 0) && ((full == true) || (value != previous)))
+	{
+		length--;
+		formatted[length] = '0' + (value % 10);
+		value /= 10;
+		previous /= 10;
+	}
 }
 
 bool SWClock::isLeapYear(int Year)
@@ -158,4 +469,71 @@ bool SWClock::isLeapYear(int Year)
         return true;
     else
         return false;
+}
+
+/***
+* Function: getMonthLength(int Year, byte Month)
+* Description: Number of days of a month
+* Params: 	Year - Year
+*			Month - Month (1 to 12)
+* Returns: Days
+***/
+byte SWClock::getMonthLength(int Year, byte Month)
+{
+	if ((Month == 2) && (isLeapYear(Year) == true))
+	{
+		return 29;
+	}
+	
+	return SWClockMonthsLength[Month - 1];
+}
+
+/***
+* Function: daysFromCivil(int Year, byte Month, byte Day)
+* Description: Days since 1970/01/01 of a date, in constant time (eras of
+*              400 years starting on March 1st, so February is last)
+* Params: 	Year - Year (1970 or later)
+*			Month - Month (1 to 12)
+*			Day - Day (1 to 31)
+* Returns: Days
+***/
+unsigned long SWClock::daysFromCivil(int Year, byte Month, byte Day)
+{
+	unsigned int yearOfEra, dayOfYear;
+	unsigned long era, dayOfEra;
+	
+	if (Month <= 2)
+	{
+		Year--;
+	}
+	era = Year / 400;
+	yearOfEra = Year - (era * 400); // [0, 399]
+	dayOfYear = (153 * (Month > 2 ? Month - 3 : Month + 9) + 2) / 5 + Day - 1; // [0, 365]
+	dayOfEra = (unsigned long) yearOfEra * 365 + (yearOfEra / 4) - (yearOfEra / 100) + dayOfYear; // [0, 146096]
+	
+	return (era * 146097) + dayOfEra - 719468; // 719468 days from 0000/03/01 to 1970/01/01
+}
+
+/***
+* Function: civilFromDays(unsigned long days, int *outYear, byte *outMonth, byte *outDay)
+* Description: Date of a day number, in constant time (inverse of daysFromCivil())
+* Params: 	days - Days since 1970/01/01
+*			outYear, outMonth, outDay - Outputs
+* Returns: none
+***/
+void SWClock::civilFromDays(unsigned long days, int *outYear, byte *outMonth, byte *outDay)
+{
+	unsigned long era, dayOfEra;
+	unsigned int yearOfEra, dayOfYear, monthIndex;
+	
+	days += 719468;
+	era = days / 146097;
+	dayOfEra = days - (era * 146097); // [0, 146096]
+	yearOfEra = (dayOfEra - (dayOfEra / 1460) + (dayOfEra / 36524) - (dayOfEra / 146096)) / 365; // [0, 399]
+	dayOfYear = dayOfEra - ((unsigned long) yearOfEra * 365 + (yearOfEra / 4) - (yearOfEra / 100)); // [0, 365]
+	monthIndex = (5 * dayOfYear + 2) / 153; // [0, 11], March first
+	
+	*outDay = dayOfYear - ((153 * monthIndex + 2) / 5) + 1;
+	*outMonth = (monthIndex < 10) ? (monthIndex + 3) : (monthIndex - 9);
+	*outYear = (era * 400) + yearOfEra + (*outMonth <= 2 ? 1 : 0);
 }
\ No newline at end of file
@@ -9,6 +9,20 @@
 * SWClock A1
 *
 * Software Clock library
+*
+* The date and time are kept as seconds since 1970/01/01-00:00:00
+* (4 bytes, valid until 2106). Adding time is a single addition; the
+* calendar date is computed only when it is requested.
+*
+* formatDateTime() keeps the last string it rendered and rewrites only
+* the fields that changed since the previous call (the date once a day,
+* hours and minutes once a minute), without sprintf().
+*
+* Drift correction: addSeconds() adds drift (ppb) of the elapsed time,
+* kept in a nanosecond accumulator so that the fraction of a second is
+* carried to the next call. sync() sets the clock from a reference time
+* and learns the drift from the error accumulated since begin() or the
+* previous sync().
 ***/
 
 
@@ -24,27 +38,56 @@
 #include "WProgram.h"
 #endif
 
+#define		SWCLOCK_EPOCH_YEAR				1970
+#define		SWCLOCK_SECONDS_PER_DAY			86400UL
+
+#define		SWCLOCK_FORMAT_DEFAULT			0 // YYYY/MM/DD-hh:mm:ss
+#define		SWCLOCK_FORMAT_ISO8601			1 // YYYY-MM-DDThh:mm:ss
+#define		SWCLOCK_FORMAT_COMPACT			2 // YYYYMMDDhhmmss
+#define		SWCLOCK_FORMAT_EPOCH			3 // Seconds since 1970/01/01-00:00:00
+#define		SWCLOCK_FORMAT_NONE				0xFF // Nothing rendered yet
+#define		SWCLOCK_STRING_LENGTH			20 // Longest formatted string with the terminator
+
+#define		SWCLOCK_NS_PER_SECOND			1000000000LL
+#define		SWCLOCK_DRIFT_MAX_PPB			10000000L // Drift correction limit (+/-10000 ppm)
+#define		SWCLOCK_SYNC_MIN_SECONDS		86400UL // Shortest interval to learn the drift from (1 s per day = 11.6 ppm)
+
 class SWClock
 {
-	int second;
-	int minute;
-	int hour;
-	int day;
-	int month;
-	int year;
+	unsigned long epoch; // Seconds since 1970/01/01-00:00:00
 	bool initialized;
+	long drift; // Correction of the elapsed time, in ppb (positive if the clock runs slow)
+	long long driftAccumulator; // Correction not yet added to epoch (ns)
+	unsigned long syncElapsed; // Seconds added since begin() or the last sync()
 	
 	public:
 		SWClock();
 		void 			begin(int newYear, int newMonth, int newDay, int newHour, int newMinute, int newSecond);
 		void 			begin(char *string);
+		void			begin(unsigned long epochSeconds);
 		bool			isInitialized();
 		byte			addTime(int sumYear, int sumMonth, int sumDay, int sumHour, int sumMinute, int sumSecond);
+		void			addSeconds(unsigned long seconds);
+		unsigned long	getEpoch();
+		void			setDrift(long driftPpb);
+		void			setDriftString(char *string);
+		long			getDrift();
+		byte			sync(unsigned long referenceEpoch);
+		void			getDateTime(int *outYear, byte *outMonth, byte *outDay, byte *outHour, byte *outMinute, byte *outSecond);
 		void			getDateTimeString(char *output);
+		const char		*formatDateTime(byte format);
 		bool			isLeapYear(int Year);
+		byte			getMonthLength(int Year, byte Month);
+		
+		static unsigned long	daysFromCivil(int Year, byte Month, byte Day);
+		static void		civilFromDays(unsigned long days, int *outYear, byte *outMonth, byte *outDay);
 
 	private:
-
+		char			formatted[SWCLOCK_STRING_LENGTH]; // Last formatDateTime() output
+		unsigned long	formattedEpoch; // Time of the last formatDateTime() output
+		byte			formattedFormat; // Format of the last formatDateTime() output
+		
+		void			formatEpoch(bool full);
 
 };
 
@@ -15,6 +15,9 @@ Si7020::Si7020() // Constructor
 	_rawTemperaturePostHumidity = 0;
 	_rawTemperature = 0;
 	_heaterLevel = 0;	
+	_resolution = SI7020_RES_RH12_TEMP14;
+	_pendingCommand = 0;
+	_resultReady = false;
 }
 
 
@@ -26,9 +29,10 @@ Si7020::Si7020() // Constructor
 ***/
 byte Si7020::begin(void)
 {
-	Wire.begin(); // Configure I2C
-	Wire.beginTransmission(SI7020_I2C_ADDRESS);
-    if (Wire.endTransmission() == 0)
+	I2C_BUS_TRACE_CALL("Si7020::begin");
+	
+	Si7020Bus::begin(); // Configure I2C
+	if (Si7020Bus::probe() == 0)
 	{
         _isEnabled = true;
     }
@@ -50,15 +54,36 @@ bool Si7020::isEnabled(void)
 
 /***
 * Function: reset(void)
-* Description: Reset device to its POR state
+* Description: Reset device to its POR state and wait (up to
+*              SI7020_RESET_TIME_MS) until it answers again
 * Params: none
-* Returns: true if the device was reset, false if not
+* Returns: 0 if the device was reset, 1 if not
 ***/
 byte Si7020::reset(void)
 {
+	I2C_BUS_TRACE_CALL("Si7020::reset");
+	
 	byte result = 0;
+	unsigned long startMs;
 	
-	result = writeByte(SI7020_CMD_WRITE_RHT_USER_REG, SI7020_CMD_RESET); //Reset user resister
+	result = Si7020Bus::writeCommand(SI7020_CMD_RESET); // Software reset (user register back to its default value)
+	
+	if (result == 0)
+	{
+		// Registers are back to their POR values, a measurement in progress is lost
+		_resolution = SI7020_RES_RH12_TEMP14;
+		_heaterLevel = 0;
+		_pendingCommand = 0;
+		_resultReady = false;
+		
+		// The device does not acknowledge its address until the reset is complete
+		startMs = millis();
+		do
+		{
+			delay(1);
+			result = Si7020Bus::probe();
+		} while ((result != 0) && ((millis() - startMs) < SI7020_RESET_TIME_MS));
+	}
 	
 	return result;
 }
@@ -72,15 +97,16 @@ byte Si7020::reset(void)
 ***/
 float Si7020::readRelHumidity(void)
 {
+	I2C_BUS_TRACE_CALL("Si7020::readRelHumidity");
+	
 	byte result = 0;
 	
 	// Measure the relative humidity 
-	result = readUInt(SI7020_CMD_MEASURE_RH_HOLD, &_rawRelativeHumidity);
+	result = readRawRelHumidity(&_rawRelativeHumidity);
 	
 	if (result == 0)
 	{
-		_rawRelativeHumidity &= 0xFFFC; // Measured value is always 0bxxxxxxxxxxxxxx10
-		return (125.0 * _rawRelativeHumidity / 65536) - 6;
+		return SI7020_RH_FROM_RAW(_rawRelativeHumidity);
 	}
 
 	return 0;
@@ -95,15 +121,17 @@ float Si7020::readRelHumidity(void)
 ***/
 float Si7020::readTemperature(void)
 {
+	I2C_BUS_TRACE_CALL("Si7020::readTemperature");
+	
 	byte result = 0;
 	
 	// Measure the temeprature
-	result = readUInt(SI7020_CMD_MEASURE_TEMP_HOLD, &_rawTemperature);
+	result = Si7020Bus::readUInt(SI7020_CMD_MEASURE_TEMP_HOLD, &_rawTemperature);
 	
 	if (result == 0)
 	{
 		_rawTemperature &= 0xFFFC; // Measured value is always 0bxxxxxxxxxxxxxx10
-		return (175.25 * _rawTemperature / 65536) - 46.85;
+		return SI7020_TEMPERATURE_FROM_RAW(_rawTemperature);
 	}
 	
 	return 0;
@@ -118,15 +146,16 @@ float Si7020::readTemperature(void)
 ***/
 float Si7020::readTemperaturePostHumidity(void)
 {
+	I2C_BUS_TRACE_CALL("Si7020::readTemperaturePostHumidity");
+	
 	byte result = 0;
 	
 	// Measure the temperature from the previous humitidy measurement
-	result = readUInt(SI7020_CMD_MEASURE_TEMP_PREV_RH, &_rawTemperaturePostHumidity);
+	result = readRawTemperaturePostHumidity(&_rawTemperaturePostHumidity);
 	
 	if (result == 0)
 	{
-		_rawTemperaturePostHumidity &= 0xFFFC; // Measured value is always 0bxxxxxxxxxxxxxx10
-		return (175.25 * _rawTemperaturePostHumidity / 65536) - 46.85;
+		return SI7020_TEMPERATURE_FROM_RAW(_rawTemperaturePostHumidity);
 	}
 	
 	return 0;
@@ -134,77 +163,116 @@ float Si7020::readTemperaturePostHumidity(void)
 
 
 /***
-* Function: setHeaterOff(void)
-* Description: Turn heater off
+* Function: readRelHumidityCenti(void)
+* Description: Read relative humidity without floating point math
 * Params: none
-* Returns: 0 if state was successfully written, 1 if not
+* Returns: Relative humidity in 0.01 % (e.g. 4512 = 45.12 %), 0 if the
+*          measurement failed
 ***/
-byte Si7020::setHeaterOff(void)
+signed int Si7020::readRelHumidityCenti(void)
 {
-	return setHeaterState(SI7020_HEATER_OFF);
+	unsigned short raw;
+	
+	if (readRawRelHumidity(&raw) == 0)
+	{
+		return SI7020_RH_CENTI_FROM_RAW(raw);
+	}
+	
+	return 0;
 }
 
 
 /***
-* Function: setHeaterOn(void)
-* Description: Turn heater on
+* Function: readTemperatureCentiC(void)
+* Description: Measure temperature without floating point math
 * Params: none
-* Returns: 0 if state was successfully written, 1 if not
+* Returns: Temperature in 0.01 Celsius degrees (e.g. 2508 = 25.08 C), 0 if
+*          the measurement failed
 ***/
-byte Si7020::setHeaterOn(void)
+signed int Si7020::readTemperatureCentiC(void)
 {
-	return setHeaterState(SI7020_HEATER_ON);
+	I2C_BUS_TRACE_CALL("Si7020::readTemperatureCentiC");
+	
+	byte result = 0;
+	
+	result = Si7020Bus::readUInt(SI7020_CMD_MEASURE_TEMP_HOLD, &_rawTemperature);
+	
+	if (result == 0)
+	{
+		_rawTemperature &= 0xFFFC; // Clear status bits
+		return SI7020_TEMPERATURE_CENTI_FROM_RAW(_rawTemperature);
+	}
+	
+	return 0;
 }
 
 
 /***
-* Function: setHeaterLevel(byte level)
-* Description: Set heater level
-* Params: level - Heater level
-* Returns: 0 if level was successfully written, 1 if not
+* Function: readTemperaturePostHumidityCentiC(void)
+* Description: Read temperature from the previous humidity measurement
+*              without floating point math
+* Params: none
+* Returns: Temperature in 0.01 Celsius degrees, 0 if the read failed
 ***/
-byte Si7020::setHeaterLevel(byte level)
+signed int Si7020::readTemperaturePostHumidityCentiC(void)
 {
-	byte result;
-	byte regValue;
+	unsigned short raw;
+	
+	if (readRawTemperaturePostHumidity(&raw) == 0)
+	{
+		return SI7020_TEMPERATURE_CENTI_FROM_RAW(raw);
+	}
+	
+	return 0;
+}
+
+
+/***
+* Function: readRawRelHumidity(unsigned short *value)
+* Description: Measure relative humidity and get the uncompensated word
+*              (to be compensated later, e.g. on a host computer)
+* Params: value - Variable to save the raw value in
+* Returns: 0 if the value was read successfully, 1 if not
+***/
+byte Si7020::readRawRelHumidity(unsigned short *value)
+{
+	I2C_BUS_TRACE_CALL("Si7020::readRawRelHumidity");
 	
-	result = readByte(SI7020_CMD_READ_HEATER_REG, &regValue);
+	byte result = 0;
+	
+	// Measure the relative humidity 
+	result = Si7020Bus::readUInt(SI7020_CMD_MEASURE_RH_HOLD, &_rawRelativeHumidity);
 	
 	if (result == 0)
 	{
-		regValue &= ~(SI7020_HEATER_LEVEL_MASK);
-		regValue |= (level & SI7020_HEATER_LEVEL_MASK);
-		
-		result = writeByte(SI7020_CMD_WRITE_HEATER_REG, regValue);
-		
-		if (result == 0)
-		{
-			_heaterLevel = level & SI7020_HEATER_LEVEL_MASK;
-		}
+		_rawRelativeHumidity &= 0xFFFC; // Measured value is always 0bxxxxxxxxxxxxxx10
+		*value = _rawRelativeHumidity;
 	}
+	
 	return result;
 }
 
 
 /***
-* Function: setResolution(byte resolution)
-* Description: Set measurement resolution
-* Params: none
-* Returns: 0 if resolution setting was successfully written, 1 if not
+* Function: readRawTemperaturePostHumidity(unsigned short *value)
+* Description: Get the uncompensated temperature word from the previous
+*              humidity measurement (to be compensated later)
+* Params: value - Variable to save the raw value in
+* Returns: 0 if the value was read successfully, 1 if not
 ***/
-byte Si7020::setResolution(byte resolution)
+byte Si7020::readRawTemperaturePostHumidity(unsigned short *value)
 {
+	I2C_BUS_TRACE_CALL("Si7020::readRawTemperaturePostHumidity");
+	
 	byte result = 0;
-	byte regValue = 0;
 	
-	result = readByte(SI7020_CMD_WRITE_RHT_USER_REG, &regValue);
+	// Read the temperature from the previous humitidy measurement
+	result = Si7020Bus::readUInt(SI7020_CMD_MEASURE_TEMP_PREV_RH, &_rawTemperaturePostHumidity);
 	
 	if (result == 0)
 	{
-		regValue &= (~SI7020_RES_MASK); // Clear resolution bits
-		regValue |= (resolution & SI7020_RES_MASK); // Set new resolution bits
-		
-		result = writeByte(SI7020_CMD_WRITE_RHT_USER_REG, regValue); // Write new value to register
+		_rawTemperaturePostHumidity &= 0xFFFC; // Measured value is always 0bxxxxxxxxxxxxxx10
+		*value = _rawTemperaturePostHumidity;
 	}
 	
 	return result;
@@ -212,174 +280,408 @@ byte Si7020::setResolution(byte resolution)
 
 
 /***
-* Function: setHeaterState(byte state)
-* Description: Set heater state
-* Params: state - Heater state setting
-* Returns: 0 if state was successfully written, 1 if not
+* Function: startRelHumidity(void)
+* Description: Start a relative humidity measurement in No Hold Master
+*              Mode. The bus is released during the conversion; poll with
+*              isReady() and get the result with fetch(). The temperature
+*              of this conversion can be read with readTemperaturePostHumidity().
+* Params: none
+* Returns: 0 if the measurement was started, 1 if not
 ***/
-byte Si7020::setHeaterState(byte state)
+byte Si7020::startRelHumidity(void)
 {
+	I2C_BUS_TRACE_CALL("Si7020::startRelHumidity");
+	
 	byte result = 0;
-	byte regValue = 0;
 	
-	result = readByte(SI7020_CMD_WRITE_RHT_USER_REG, &regValue);
+	_resultReady = false;
+	result = Si7020Bus::writeCommand(SI7020_CMD_MEASURE_RH_NO_HOLD);
 	
 	if (result == 0)
 	{
-		regValue &= (~SI7020_HEATER_MASK); // Clear resolution bits
-		regValue |= (state & SI7020_HEATER_MASK); // Set new resolution bits
-		
-		result = writeByte(SI7020_CMD_WRITE_RHT_USER_REG, regValue); // Write new value to register
+		_pendingCommand = SI7020_CMD_MEASURE_RH_NO_HOLD;
 	}
 	
 	return result;
 }
 
 
-// I2C R/W functions
-
 /***
-* Function: readInt(byte address, signed short *value)
-* Description: Read 16-bit signed integer from device
-* Params: address - Register address
-*         value - Variable to save the value in
-* Returns: 0 if the value was read successfully, 1 if not
+* Function: startTemperature(void)
+* Description: Start a temperature measurement in No Hold Master Mode
+*              (see startRelHumidity())
+* Params: none
+* Returns: 0 if the measurement was started, 1 if not
 ***/
-byte Si7020::readInt(byte address, signed short *value)
+byte Si7020::startTemperature(void)
 {
-	byte result;
-	byte byteCount = 0;
-	byte data[2] = { 0, 0};
+	I2C_BUS_TRACE_CALL("Si7020::startTemperature");
 	
-	Wire.beginTransmission(SI7020_I2C_ADDRESS);
-	Wire.write(address);
-	result = Wire.endTransmission();
+	byte result = 0;
+	
+	_resultReady = false;
+	result = Si7020Bus::writeCommand(SI7020_CMD_MEASURE_TEMP_NO_HOLD);
 	
-	if(readByteArray(address,data,2) == 0)
+	if (result == 0)
 	{
-		*value = (((unsigned short) data[0]) << 8) | data[1]; 
+		_pendingCommand = SI7020_CMD_MEASURE_TEMP_NO_HOLD;
 	}
-		
+	
 	return result;
 }
 
 
 /***
-* Function: readUInt(byte address, unsigned short *value)
-* Description: Read 16-bit unsigned integer from device
-* Params: address - Register address
-*         value - Variable to save the value in
-* Returns: 0 if the value was read successfully, 1 if not
+* Function: isReady(void)
+* Description: Poll the No Hold Master measurement. The device does not
+*              acknowledge reads until the conversion is done; once it
+*              does, the result is read and saved.
+* Params: none
+* Returns: true if the result is available, false if not
 ***/
-byte Si7020::readUInt(byte address, unsigned short *value)
+bool Si7020::isReady(void)
 {
-	byte result;
-	byte byteCount = 0;
-	byte data[2] = { 0, 0};
+	I2C_BUS_TRACE_CALL("Si7020::isReady");
+	
+	byte data[2];
+	unsigned short value;
+	
+	if (_pendingCommand == 0)
+	{
+		return _resultReady; // Nothing in progress
+	}
+	
+	if (Si7020Bus::read(data, 2) != 0)
+	{
+		return false; // NACK: conversion in progress
+	}
+	
+	value = Si7020Bus::toUInt(data) & 0xFFFC; // Clear status bits
 	
-	if(readByteArray(address,data,2) == 0)
+	if (_pendingCommand == SI7020_CMD_MEASURE_RH_NO_HOLD)
+	{
+		_rawRelativeHumidity = value;
+	}
+	else
 	{
-		*value = (((unsigned short) data[0]) << 8) | data[1]; 
+		_rawTemperature = value;
 	}
+	
+	_pendingCommand = 0;
+	_resultReady = true;
+	
+	return true;
+}
 
-	return result;
+
+/***
+* Function: fetch(void)
+* Description: Get the result of the No Hold Master measurement. Use
+*              getRelHumidity() or getTemperature() to read it.
+* Params: none
+* Returns: 0 if the result is available, 1 if the conversion is still
+*          in progress or no measurement was started
+***/
+byte Si7020::fetch(void)
+{
+	return (isReady() == true) ? 0 : 1;
 }
 
 
 /***
-* Function: readByte(unsigned char address, unsigned char *value)
-* Description: Read byte from device
-* Params: address - Register address
-*         value - Variable to save the value in
-* Returns: 0 if the value was read successfully, 1 if not
+* Function: getRelHumidity(void)
+* Description: Get relative humidity from the last fetched measurement
+* Params: none
+* Returns: Relative humidity value
+***/
+float Si7020::getRelHumidity(void)
+{
+	return SI7020_RH_FROM_RAW(_rawRelativeHumidity);
+}
+
+
+/***
+* Function: getTemperature(void)
+* Description: Get temperature from the last fetched measurement
+* Params: none
+* Returns: Temperature value in Celsius degrees
+***/
+float Si7020::getTemperature(void)
+{
+	return SI7020_TEMPERATURE_FROM_RAW(_rawTemperature);
+}
+
+
+/***
+* Function: getRelHumidityCenti(void)
+* Description: Get relative humidity from the last fetched measurement
+*              without floating point math
+* Params: none
+* Returns: Relative humidity in 0.01 %
 ***/
-byte Si7020::readByte(byte address, byte *value)
+signed int Si7020::getRelHumidityCenti(void)
 {
+	return SI7020_RH_CENTI_FROM_RAW(_rawRelativeHumidity);
+}
+
+
+/***
+* Function: getTemperatureCentiC(void)
+* Description: Get temperature from the last fetched measurement without
+*              floating point math
+* Params: none
+* Returns: Temperature in 0.01 Celsius degrees
+***/
+signed int Si7020::getTemperatureCentiC(void)
+{
+	return SI7020_TEMPERATURE_CENTI_FROM_RAW(_rawTemperature);
+}
+
+
+/***
+* Function: getRawRelHumidity(void)
+* Description: Get the uncompensated relative humidity word from the
+*              last fetched measurement
+* Params: none
+* Returns: Raw relative humidity word
+***/
+unsigned short Si7020::getRawRelHumidity(void)
+{
+	return _rawRelativeHumidity;
+}
+
+
+/***
+* Function: getRawTemperature(void)
+* Description: Get the uncompensated temperature word from the last
+*              fetched measurement
+* Params: none
+* Returns: Raw temperature word
+***/
+unsigned short Si7020::getRawTemperature(void)
+{
+	return _rawTemperature;
+}
+
+
+/***
+* Function: setHeaterOff(void)
+* Description: Turn heater off
+* Params: none
+* Returns: 0 if state was successfully written, 1 if not
+***/
+byte Si7020::setHeaterOff(void)
+{
+	return setHeaterState(SI7020_HEATER_OFF);
+}
+
+
+/***
+* Function: setHeaterOn(void)
+* Description: Turn heater on
+* Params: none
+* Returns: 0 if state was successfully written, 1 if not
+***/
+byte Si7020::setHeaterOn(void)
+{
+	return setHeaterState(SI7020_HEATER_ON);
+}
+
+
+/***
+* Function: setHeaterLevel(byte level)
+* Description: Set heater level
+* Params: level - Heater level
+* Returns: 0 if level was successfully written, 1 if not
+***/
+byte Si7020::setHeaterLevel(byte level)
+{
+	I2C_BUS_TRACE_CALL("Si7020::setHeaterLevel");
+	
 	byte result;
+	byte regValue;
 	
-	Wire.beginTransmission(SI7020_I2C_ADDRESS);
-	Wire.write(address);
-	result = Wire.endTransmission();
+	result = Si7020Bus::readByte(SI7020_CMD_READ_HEATER_REG, &regValue);
 	
 	if (result == 0)
 	{
-		Wire.requestFrom(SI7020_I2C_ADDRESS,1);
-		while(Wire.available()) // Wait until bytes are ready to read
+		regValue &= ~(SI7020_HEATER_LEVEL_MASK);
+		regValue |= (level & SI7020_HEATER_LEVEL_MASK);
+		
+		result = Si7020Bus::writeByte(SI7020_CMD_WRITE_HEATER_REG, regValue);
+		
+		if (result == 0)
 		{
-			*value = Wire.read(); // Read byte
+			_heaterLevel = level & SI7020_HEATER_LEVEL_MASK;
 		}
 	}
-		
 	return result;
 }
 
 
 /***
-* Function: readByteArray(unsigned char address, unsigned char * array, unsigned char length)
-* Description: Read byte array from device
-* Params: address - Register address
-*         array - Variable to save the values in
-*         length - Number of bytes to read
-* Returns: 0 if the values were read successfully, 1 if not
+* Function: getNackCount(void)
+* Description: Get number of I2C operations not acknowledged by the device
+* Params: none
+* Returns: Number of NACKs since the last reset
 ***/
-byte Si7020::readByteArray(byte address, unsigned char * array, byte length)
+unsigned int Si7020::getNackCount(void)
 {
-	byte result;
-	byte byteCount = 0;
-	Wire.beginTransmission(SI7020_I2C_ADDRESS);
-	Wire.write(address);
-	result = Wire.endTransmission();
+	return Si7020Bus::getNackCount();
+}
+
+
+/***
+* Function: getTimeoutCount(void)
+* Description: Get number of I2C operations that timed out
+* Params: none
+* Returns: Number of timeouts since the last reset
+***/
+unsigned int Si7020::getTimeoutCount(void)
+{
+	return Si7020Bus::getTimeoutCount();
+}
+
+
+/***
+* Function: getRetryCount(void)
+* Description: Get number of retried I2C transactions
+* Params: none
+* Returns: Number of retries since the last reset
+***/
+unsigned int Si7020::getRetryCount(void)
+{
+	return Si7020Bus::getRetryCount();
+}
+
+
+/***
+* Function: resetErrorCounters(void)
+* Description: Reset I2C error counters
+* Params: none
+* Returns: none
+***/
+void Si7020::resetErrorCounters(void)
+{
+	Si7020Bus::resetErrorCounters();
+}
+
+
+/***
+* Function: setResolution(byte resolution)
+* Description: Set measurement resolution. Lower resolutions have
+*              shorter conversions (see getConversionTimeUs()).
+* Params: resolution - SI7020_RES_RH12_TEMP14, SI7020_RES_RH11_TEMP11,
+*                      SI7020_RES_RH10_TEMP13 or SI7020_RES_RH08_TEMP12
+* Returns: 0 if resolution setting was successfully written, 1 if not
+***/
+byte Si7020::setResolution(byte resolution)
+{
+	I2C_BUS_TRACE_CALL("Si7020::setResolution");
+	
+	byte result = 0;
+	byte regValue = 0;
+	
+	result = Si7020Bus::readByte(SI7020_CMD_READ_RHT_USER_REG, &regValue);
 	
 	if (result == 0)
 	{
-		byte i;
+		regValue &= (~SI7020_RES_MASK); // Clear resolution bits
+		regValue |= (resolution & SI7020_RES_MASK); // Set new resolution bits
 		
-		Wire.requestFrom(SI7020_I2C_ADDRESS,(int)length);
-		while(Wire.available()) // Wait until bytes are ready to read
-		{
-			array[byteCount++] = Wire.read(); // Read byte
-		}
+		result = Si7020Bus::writeByte(SI7020_CMD_WRITE_RHT_USER_REG, regValue); // Write new value to register
 	}
-		
+	
+	if (result == 0)
+	{
+		_resolution = resolution & SI7020_RES_MASK;
+	}
+	
 	return result;
 }
 
 
 /***
-* Function: writeByte(unsigned char address, unsigned char value)
-* Description: Write byte to device
-* Params: address - Register address
-*         value - Value to write
-* Returns: 0 if the value was written successfully, 1 if not
+* Function: getResolution(void)
+* Description: Get the measurement resolution setting
+* Params: none
+* Returns: Resolution setting (SI7020_RES_xxx)
 ***/
-byte Si7020::writeByte(byte address, byte value)
+byte Si7020::getResolution(void)
 {
-	byte result;
-	
-	Wire.beginTransmission(SI7020_I2C_ADDRESS);
-	Wire.write(address);
-	Wire.write(value);
-	result = Wire.endTransmission();
+	return _resolution;
+}
 
-	return result;
+
+/***
+* Function: getConversionTimeUs(void)
+* Description: Get the maximum relative humidity conversion time for the
+*              current resolution (includes the temperature conversion).
+*              Useful to sleep before polling a No Hold Master measurement.
+* Params: none
+* Returns: Conversion time in us
+***/
+unsigned int Si7020::getConversionTimeUs(void)
+{
+	switch (_resolution)
+	{
+		case SI7020_RES_RH08_TEMP12:
+			return SI7020_CONV_TIME_RH08_TEMP12_US;
+		case SI7020_RES_RH10_TEMP13:
+			return SI7020_CONV_TIME_RH10_TEMP13_US;
+		case SI7020_RES_RH11_TEMP11:
+			return SI7020_CONV_TIME_RH11_TEMP11_US;
+		default:
+			return SI7020_CONV_TIME_RH12_TEMP14_US;
+	}
 }
 
 
 /***
-* Function: writeByteArray(unsigned char address, unsigned char * array, unsigned char length)
-* Description: Write byte array to device
-* Params: address - Register address
-*         value - Value to write
-* Returns: 0 if the value was written successfully, 1 if not
+* Function: getTemperatureConversionTimeUs(void)
+* Description: Get the maximum temperature conversion time for the
+*              current resolution
+* Params: none
+* Returns: Conversion time in us
 ***/
-byte Si7020::writeByteArray(byte address, unsigned char * array, byte length)
+unsigned int Si7020::getTemperatureConversionTimeUs(void)
 {
-	byte result;
-	
-	Wire.beginTransmission(SI7020_I2C_ADDRESS);
-	Wire.write(address);
-	Wire.write(array, length);
-	result = Wire.endTransmission();
+	switch (_resolution)
+	{
+		case SI7020_RES_RH08_TEMP12:
+			return SI7020_CONV_TIME_TEMP12_US;
+		case SI7020_RES_RH10_TEMP13:
+			return SI7020_CONV_TIME_TEMP13_US;
+		case SI7020_RES_RH11_TEMP11:
+			return SI7020_CONV_TIME_TEMP11_US;
+		default:
+			return SI7020_CONV_TIME_TEMP14_US;
+	}
+}
 
+
+/***
+* Function: setHeaterState(byte state)
+* Description: Set heater state
+* Params: state - Heater state setting
+* Returns: 0 if state was successfully written, 1 if not
+***/
+byte Si7020::setHeaterState(byte state)
+{
+	I2C_BUS_TRACE_CALL("Si7020::setHeaterState");
+	
+	byte result = 0;
+	byte regValue = 0;
+	
+	result = Si7020Bus::readByte(SI7020_CMD_READ_RHT_USER_REG, &regValue);
+	
+	if (result == 0)
+	{
+		regValue &= (~SI7020_HEATER_MASK); // Clear heater bit
+		regValue |= (state & SI7020_HEATER_MASK); // Set new heater bit
+		
+		result = Si7020Bus::writeByte(SI7020_CMD_WRITE_RHT_USER_REG, regValue); // Write new value to register
+	}
+	
 	return result;
 }
\ No newline at end of file
@@ -24,9 +24,22 @@
 #endif
 
 #include <Wire.h>
+#include <I2CBus.h>
 
 #define		SI7020_I2C_ADDRESS						0x40
 
+// I2C transactions
+#define		SI7020_I2C_TIMEOUT_US					25000 // Maximum duration of each bus operation (covers a hold master conversion)
+#define		SI7020_I2C_TRANSACTION_MAX_US			I2C_BUS_TRANSACTION_MAX_US(SI7020_I2C_TIMEOUT_US) // Worst case duration
+
+// Conversion of the raw words (datasheet section 5.1)
+#define		SI7020_RH_FROM_RAW(x)					((125.0 * (x) / 65536) - 6)
+#define		SI7020_TEMPERATURE_FROM_RAW(x)			((175.25 * (x) / 65536) - 46.85)
+
+// Same conversions in fixed point (0.01 %RH and 0.01 Celsius degrees, rounded), 32-bit math only
+#define		SI7020_RH_CENTI_FROM_RAW(x)				((signed int) ((12500UL * (x) + 32768UL) >> 16) - 600)
+#define		SI7020_TEMPERATURE_CENTI_FROM_RAW(x)	((signed int) ((17525UL * (x) + 32768UL) >> 16) - 4685)
+
 #define 	SI7020_CMD_MEASURE_RH_HOLD					0xE5
 #define 	SI7020_CMD_MEASURE_RH_NO_HOLD				0xF5
 #define 	SI7020_CMD_MEASURE_TEMP_HOLD				0xE3
@@ -60,11 +73,26 @@
 #define		SI7020_RES_RH10_TEMP13						0x80
 #define		SI7020_RES_RH11_TEMP11						0x81
 
+// Maximum conversion times in us (datasheet table 2)
+// Relative humidity measurements include a temperature conversion
+#define		SI7020_CONV_TIME_RH12_TEMP14_US				22800 // 12.0 ms + 10.8 ms
+#define		SI7020_CONV_TIME_RH11_TEMP11_US				9400 // 7.0 ms + 2.4 ms
+#define		SI7020_CONV_TIME_RH10_TEMP13_US				10700 // 4.5 ms + 6.2 ms
+#define		SI7020_CONV_TIME_RH08_TEMP12_US				6900 // 3.1 ms + 3.8 ms
+#define		SI7020_CONV_TIME_TEMP14_US					10800
+#define		SI7020_CONV_TIME_TEMP13_US					6200
+#define		SI7020_CONV_TIME_TEMP12_US					3800
+#define		SI7020_CONV_TIME_TEMP11_US					2400
+#define		SI7020_RESET_TIME_MS						15 // Powerup time after a software reset
+
 #define		SI7020_HEATER_MASK							0x04
 #define		SI7020_HEATER_OFF							0x00
 #define		SI7020_HEATER_ON							0x04
 #define		SI7020_HEATER_LEVEL_MASK					0x0F
 
+/* Register access (16-bit results are MSB first) */
+typedef I2CBus<SI7020_I2C_ADDRESS, I2C_BUS_MSB_FIRST, SI7020_I2C_TIMEOUT_US> Si7020Bus;
+
 
 class Si7020
 {
@@ -77,9 +105,32 @@ class Si7020
 		float 	readRelHumidity(void); // Read relative humidity
 		float 	readTemperature(void); // Read temperature in Celsius degrees
 		float 	readTemperaturePostHumidity(void); // Read temperature from the previous humidity measurement
+		signed int readRelHumidityCenti(void); // Read relative humidity in 0.01 % without floating point math
+		signed int readTemperatureCentiC(void); // Read temperature in 0.01 Celsius degrees without floating point math
+		signed int readTemperaturePostHumidityCentiC(void); // Read temperature from the previous humidity measurement in 0.01 Celsius degrees
+		byte 	readRawRelHumidity(unsigned short *value); // Measure relative humidity and get the uncompensated 16-bit word
+		byte 	readRawTemperaturePostHumidity(unsigned short *value); // Get the uncompensated 16-bit temperature word from the previous humidity measurement
+		byte 	startRelHumidity(void); // Start a relative humidity measurement without holding the bus (No Hold Master Mode)
+		byte 	startTemperature(void); // Start a temperature measurement without holding the bus (No Hold Master Mode)
+		bool 	isReady(void); // Poll the measurement started with startRelHumidity() or startTemperature()
+		byte 	fetch(void); // Get the result of the measurement started with startRelHumidity() or startTemperature()
+		float 	getRelHumidity(void); // Get relative humidity from the last fetched measurement
+		float 	getTemperature(void); // Get temperature from the last fetched measurement
+		signed int getRelHumidityCenti(void); // Get relative humidity in 0.01 % from the last fetched measurement
+		signed int getTemperatureCentiC(void); // Get temperature in 0.01 Celsius degrees from the last fetched measurement
+		unsigned short getRawRelHumidity(void); // Get the uncompensated relative humidity word from the last fetched measurement
+		unsigned short getRawTemperature(void); // Get the uncompensated temperature word from the last fetched measurement
 		byte 	setHeaterOff(void); // Turn heater off
 		byte 	setHeaterOn(void); // Turn heater on
 		byte 	setHeaterLevel(byte level); // Set heater level
+		byte 	setResolution(byte resolution); // Set measurement resolution (SI7020_RES_xxx)
+		byte 	getResolution(void); // Get the measurement resolution setting
+		unsigned int getConversionTimeUs(void); // Get the maximum relative humidity conversion time for the current resolution
+		unsigned int getTemperatureConversionTimeUs(void); // Get the maximum temperature conversion time for the current resolution
+		unsigned int getNackCount(void); // Get number of I2C operations not acknowledged by the device
+		unsigned int getTimeoutCount(void); // Get number of I2C operations that timed out
+		unsigned int getRetryCount(void); // Get number of retried I2C transactions
+		void 	resetErrorCounters(void); // Reset I2C error counters
 		
 	private:
 		bool _isEnabled;
@@ -87,16 +138,12 @@ class Si7020
 		unsigned short _rawTemperaturePostHumidity;
 		unsigned short _rawTemperature;
 		byte _heaterLevel;
+		byte _resolution;
+		byte _pendingCommand; // No Hold Master measurement in progress (0 if none)
+		bool _resultReady; // Result of the last No Hold Master measurement was read
 		
-		byte 	setResolution(byte resolution); // Set measurement resolution
 		byte 	setHeaterState(byte state); // Set heater state
 		
-		byte 	readInt(byte address, signed short *value); // Read 16-bit signed integer from device
-		byte 	readUInt(byte address, unsigned short *value); // Read 16-bit unsigned integer from device
-		byte 	readByte(byte address, byte *value); // Read byte from device
-		byte 	readByteArray(byte address, unsigned char * array, byte length); // Read byte array from device
-		byte 	writeByte(byte address, byte value); // Write byte to device
-		byte 	writeByteArray(byte address, unsigned char * array, byte length); // Write byte array to device
 };
 
 